@@ -49,8 +49,14 @@ def parse_experiment_result(txt_file):
                 current_experiment['query_limit'] = int(line.replace('> Query Limit: ', '').lstrip('"').rstrip('"'))
             elif line.startswith('> Excepted Errors: '):
                 current_experiment['error_total'] = int(line.replace('> Excepted Errors: ', '').lstrip('"').rstrip('"'))
+            elif line.startswith('> Strand: '):
+                current_experiment['strand'] = line.replace('> Strand: ', '').strip()
+            elif line.startswith('> Threads: '):
+                current_experiment['threads'] = int(line.replace('> Threads: ', '').strip())
             elif line.startswith('> Search duration: '):
                 current_experiment['query_time_ms'] = parse_duration_str(line.replace('> Search duration: ', '').strip())
+            elif line.startswith('> Search allocations: '):
+                current_experiment['search_allocations'] = int(line.replace('> Search allocations: ', '').strip())
             elif line.strip().startswith('Maximum resident set size '):
                 current_experiment['mem_peak_kbytes'] = parse_mem_str(line.replace('Maximum resident set size ', '').strip())
     if current_experiment is not None and len(current_experiment) > 0:
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+// Aho-Corasick automaton over dna5 ranks, matching many patterns in one pass over a text.
+// The goto function is completed into a dfa, so every text character costs one table lookup. States that end
+// patterns are chained through dictionary links, a state's match count covers its whole chain.
+// The buffers are reused, so after the largest pattern set has been seen no build allocates.
+class aho_corasick {
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    std::vector<std::array<uint32_t, 5>> next_;
+    std::vector<uint32_t> fail_;
+    std::vector<uint32_t> first_pattern_; // per state, first pattern ending in it
+    std::vector<uint32_t> next_pattern_;  // per pattern, next pattern ending in the same state
+    std::vector<uint32_t> dictionary_;    // per state, longest proper suffix state that ends patterns, 0 if none
+    std::vector<uint64_t> match_count_;   // per state, number of patterns ending in it or its dictionary chain
+    std::vector<uint32_t> pattern_length_;
+    std::vector<uint32_t> queue_;
+
+    uint32_t new_state() {
+        next_.push_back({none, none, none, none, none});
+        first_pattern_.push_back(none);
+        return next_.size() - 1;
+    }
+
+public:
+    aho_corasick() { clear(); }
+
+    // removes all patterns
+    void clear() {
+        next_.clear();
+        first_pattern_.clear();
+        next_pattern_.clear();
+        pattern_length_.clear();
+        new_state();
+    }
+
+    // adds a non-empty pattern and returns its id, ids are given out in order starting at 0
+    uint32_t add(std::vector<seqan3::dna5> const& pattern) {
+        uint32_t state = 0;
+        for (auto c : pattern) {
+            auto& next = next_[state][seqan3::to_rank(c)];
+            if (next == none) {
+                uint32_t created = new_state();
+                next_[state][seqan3::to_rank(c)] = created;
+                state = created;
+            } else {
+                state = next;
+            }
+        }
+        uint32_t id = pattern_length_.size();
+        pattern_length_.push_back(pattern.size());
+        next_pattern_.push_back(first_pattern_[state]);
+        first_pattern_[state] = id;
+        return id;
+    }
+
+    // computes failure and dictionary links breadth first, call after the last add
+    void build() {
+        size_t const states = next_.size();
+        fail_.assign(states, 0);
+        dictionary_.assign(states, 0);
+        match_count_.assign(states, 0);
+        queue_.clear();
+        for (auto& next : next_[0]) {
+            if (next == none) {
+                next = 0;
+            } else {
+                queue_.push_back(next);
+            }
+        }
+        for (size_t head = 0; head < queue_.size(); ++head) {
+            uint32_t state = queue_[head];
+            uint32_t fail = fail_[state];
+            dictionary_[state] = first_pattern_[fail] != none ? fail : dictionary_[fail];
+            match_count_[state] = match_count_[fail];
+            for (uint32_t p = first_pattern_[state]; p != none; p = next_pattern_[p]) {
+                ++match_count_[state];
+            }
+            for (size_t c = 0; c < 5; ++c) {
+                uint32_t& next = next_[state][c];
+                if (next == none) {
+                    next = next_[fail][c];
+                } else {
+                    fail_[next] = next_[fail][c];
+                    queue_.push_back(next);
+                }
+            }
+        }
+    }
+
+    uint32_t step(uint32_t state, uint8_t rank) const { return next_[state][rank]; }
+
+    // number of patterns ending at the current text position
+    uint64_t match_count(uint32_t state) const { return match_count_[state]; }
+
+    // calls fn(pattern id) for every pattern ending at the current text position
+    template <typename fn_t>
+    void for_each_match(uint32_t state, fn_t&& fn) const {
+        for (; state != 0; state = dictionary_[state]) {
+            for (uint32_t p = first_pattern_[state]; p != none; p = next_pattern_[p]) {
+                fn(p);
+            }
+        }
+    }
+
+    size_t pattern_length(uint32_t id) const { return pattern_length_[id]; }
+};
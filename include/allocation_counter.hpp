@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts the heap allocations of every thread, src/allocation_counter.cpp replaces the global operator new for
+// this. The benchmark output reports the allocations made while searching, so they can be checked per read.
+// Replacing operator new affects the whole program, so only the benchmark executables link allocation_counter.cpp;
+// the library holds a weak definition that counts nothing.
+
+// number of allocations the calling thread made so far, always 0 unless the executable links allocation_counter.cpp
+uint64_t thread_allocation_count();
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+// fifo with a fixed capacity, push blocks while it is full and pop blocks while it is empty
+template <typename T>
+class bounded_queue {
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    size_t capacity_;
+    bool closed_ = false;
+
+public:
+    explicit bounded_queue(size_t capacity)
+        : capacity_{std::max<size_t>(1, capacity)} {}
+
+    // returns false if the queue was closed, the item is dropped then
+    bool push(T item) {
+        std::unique_lock lock{mutex_};
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // returns nullopt once the queue is closed and drained
+    std::optional<T> pop() {
+        std::unique_lock lock{mutex_};
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return std::nullopt;
+        T item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return item;
+    }
+
+    // no further pushes, the remaining items can still be popped
+    void close() {
+        std::lock_guard lock{mutex_};
+        closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    // no further pushes and the remaining items are dropped
+    void cancel() {
+        std::lock_guard lock{mutex_};
+        closed_ = true;
+        items_.clear();
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+};
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+#include "mapped_file.hpp"
+#include "packed_reference.hpp"
+
+// On-disk layout of the flat fm-index. Every section starts at a multiple of 64 bytes, so the
+// file can be mmap'ed and queried in place without any deserialization.
+//
+//   [flat_fm_header][flat_fm_block * block_count][uint64_t sequence_starts[sequence_count + 1]]
+//   [uint64_t sa_samples[sample_count]][packed text words][n runs]
+//
+// The indexed text is the concatenation of all reference sequences, each terminated by the
+// separator symbol 0. All other symbols are the dna5 rank + 1 (A=1, C=2, G=3, N=4, T=5).
+// A bwt position is sampled if its suffix array value is a multiple of sa_sample_rate or the
+// start of a sequence, so walking backwards to the next sample never crosses a separator.
+// The packed text holds the sequences without separators.
+//
+// An index built with the reverse complement holds the reverse complement of every sequence after all
+// sequences, so a single backward search of a query finds it on both strands. The packed text holds the
+// sequences only, the reverse complements are never verified against.
+inline constexpr char flat_fm_magic[8] = {'I', 'S', 'F', 'M', 'I', 'D', 'X', '\0'};
+inline constexpr uint32_t flat_fm_version = 3; // version 2 lacks the reverse complement field
+inline constexpr size_t flat_fm_sigma = 6;
+inline constexpr size_t flat_fm_block_size = 256;
+inline constexpr size_t flat_fm_sampled_plane = 3;
+
+struct alignas(64) flat_fm_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t text_length;        // including one separator per sequence
+    uint64_t sequence_count;
+    uint64_t block_count;
+    uint64_t blocks_offset;
+    uint64_t sequence_starts_offset;
+    uint64_t C[flat_fm_sigma + 1]; // number of symbols in the text smaller than c
+    uint64_t sa_sample_rate;
+    uint64_t sample_count;
+    uint64_t samples_offset;
+    uint64_t words_offset;
+    uint64_t runs_offset;
+    uint64_t run_count;
+    uint64_t reverse_complement; // 1 if the last sequence_count / 2 sequences are reverse complements, since version 3
+};
+
+// 256 bwt symbols, stored as 3 bit planes per 64 symbols plus a plane marking sampled positions,
+// and the occurrences of every symbol (and of sampled positions) before the block
+struct alignas(64) flat_fm_block {
+    uint64_t occ[8]; // [0, flat_fm_sigma): symbols, flat_fm_sigma: sampled positions
+    uint64_t planes[flat_fm_block_size / 64][4];
+};
+
+static_assert(sizeof(flat_fm_header) % 64 == 0);
+static_assert(sizeof(flat_fm_block) % 64 == 0);
+
+inline uint8_t flat_fm_code(seqan3::dna5 c) {
+    return seqan3::to_rank(c) + 1;
+}
+
+// true if the file at `path` starts with the flat fm-index magic
+inline bool is_flat_fm_index(std::filesystem::path const& path) {
+    std::ifstream is{path, std::ios::binary};
+    char magic[sizeof(flat_fm_magic)]{};
+    is.read(magic, sizeof(magic));
+    return is && std::memcmp(magic, flat_fm_magic, sizeof(magic)) == 0;
+}
+
+class flat_fm_index {
+    mapped_file file;
+    flat_fm_header const* header = nullptr;
+    flat_fm_block const* blocks = nullptr;
+    uint64_t const* starts = nullptr;
+    uint64_t const* samples = nullptr;
+    uint64_t reverse_complement = 0;
+
+    static uint64_t symbol_mask(uint64_t const* p, uint8_t c) {
+        return ((c & 1) ? p[0] : ~p[0])
+             & ((c & 2) ? p[1] : ~p[1])
+             & ((c & 4) ? p[2] : ~p[2]);
+    }
+
+    // number of positions in [block begin, i) whose bits are selected by mask_of(word)
+    template <typename mask_fn_t>
+    static uint64_t block_rank(flat_fm_block const& block, size_t offset, mask_fn_t&& mask_of) {
+        uint64_t count = 0;
+        for (size_t w = 0; w * 64 < offset; ++w) {
+            uint64_t bits = mask_of(block.planes[w]);
+            size_t rem = offset - w * 64;
+            if (rem < 64) {
+                bits &= (uint64_t{1} << rem) - 1;
+            }
+            count += std::popcount(bits);
+        }
+        return count;
+    }
+
+    // number of occurrences of symbol c in bwt[0, i)
+    uint64_t occ(uint8_t c, uint64_t i) const {
+        auto const& block = blocks[i / flat_fm_block_size];
+        return block.occ[c] + block_rank(block, i % flat_fm_block_size,
+                                         [c](uint64_t const* p) { return symbol_mask(p, c); });
+    }
+
+    uint8_t bwt(uint64_t i) const {
+        auto const& p = blocks[i / flat_fm_block_size].planes[(i % flat_fm_block_size) / 64];
+        size_t bit = i % 64;
+        return ((p[0] >> bit) & 1) | (((p[1] >> bit) & 1) << 1) | (((p[2] >> bit) & 1) << 2);
+    }
+
+    template <typename query_t, typename callback_t>
+    void search_hamming(query_t const& query, size_t i, uint64_t sp, uint64_t ep,
+                        size_t errors_left, size_t errors_used, callback_t& on_interval) const {
+        if (i == 0) {
+            on_interval(sp, ep, errors_used);
+            return;
+        }
+        uint8_t expected = flat_fm_code(query[i - 1]);
+        if (errors_left == 0) {
+            if (backward_step(expected, sp, ep)) {
+                search_hamming(query, i - 1, sp, ep, 0, errors_used, on_interval);
+            }
+            return;
+        }
+        for (uint8_t c = 1; c < flat_fm_sigma; ++c) {
+            uint64_t s = sp, e = ep;
+            if (backward_step(c, s, e)) {
+                bool mismatch = c != expected;
+                search_hamming(query, i - 1, s, e, errors_left - mismatch, errors_used + mismatch, on_interval);
+            }
+        }
+    }
+
+public:
+    flat_fm_index() = default;
+
+    explicit flat_fm_index(std::filesystem::path const& path) : file{path} {
+        if (file.size() < sizeof(flat_fm_header)) {
+            throw std::runtime_error(path.string() + " is too small to be a flat fm-index");
+        }
+        header = reinterpret_cast<flat_fm_header const*>(file.data());
+        if (std::memcmp(header->magic, flat_fm_magic, sizeof(flat_fm_magic)) != 0) {
+            throw std::runtime_error(path.string() + " is not a flat fm-index");
+        }
+        if ((header->version != flat_fm_version && header->version != 2) || header->header_size != sizeof(flat_fm_header)) {
+            throw std::runtime_error(path.string() + " has unsupported flat fm-index version "
+                                     + std::to_string(header->version));
+        }
+        if (file.size() < header->runs_offset + header->run_count * sizeof(n_run)) {
+            throw std::runtime_error(path.string() + " is truncated");
+        }
+        blocks = reinterpret_cast<flat_fm_block const*>(file.data() + header->blocks_offset);
+        starts = reinterpret_cast<uint64_t const*>(file.data() + header->sequence_starts_offset);
+        samples = reinterpret_cast<uint64_t const*>(file.data() + header->samples_offset);
+        reverse_complement = header->version >= 3 ? header->reverse_complement : 0;
+        if (reverse_complement > 1 || (reverse_complement == 1 && header->sequence_count % 2 != 0)) {
+            throw std::runtime_error(path.string() + " has an invalid reverse complement field");
+        }
+        file.advise(MADV_RANDOM);
+    }
+
+    uint64_t size() const { return header->text_length; }
+    // number of reference sequences, without their reverse complements
+    uint64_t sequence_count() const { return header->sequence_count >> reverse_complement; }
+    bool has_reverse_complement() const { return reverse_complement != 0; }
+    uint64_t sa_sample_rate() const { return header->sa_sample_rate; }
+    // begin of sequence `id` inside the concatenated text, ids from sequence_count() on are the reverse
+    // complements of the ids sequence_count() before them
+    uint64_t sequence_start(uint64_t id) const { return starts[id]; }
+    uint64_t sequence_length(uint64_t id) const { return starts[id + 1] - starts[id] - 1; }
+
+    // the reference sequences without separators, sequence `id` starts at sequence_start(id) - id
+    packed_reference_view text() const {
+        return {reinterpret_cast<uint64_t const*>(file.data() + header->words_offset),
+                reinterpret_cast<n_run const*>(file.data() + header->runs_offset),
+                sequence_start(sequence_count()) - sequence_count(),
+                header->run_count};
+    }
+
+    // narrows the sa interval [sp, ep) to the suffixes preceded by c, returns false if it becomes empty
+    bool backward_step(uint8_t c, uint64_t& sp, uint64_t& ep) const {
+        sp = header->C[c] + occ(c, sp);
+        ep = header->C[c] + occ(c, ep);
+        return sp < ep;
+    }
+
+    // calls on_interval(sp, ep, errors) for every sa interval of text substrings that match query
+    // with at most `errors` substitutions
+    template <typename query_t, typename callback_t>
+    void search(query_t const& query, size_t errors, callback_t&& on_interval) const {
+        search_hamming(query, query.size(), 0, size(), errors, 0, on_interval);
+    }
+
+    // number of text positions matching query with at most `errors` substitutions
+    template <typename query_t>
+    uint64_t count(query_t const& query, size_t errors = 0) const {
+        uint64_t total = 0;
+        search(query, errors, [&total](uint64_t sp, uint64_t ep, size_t) { total += ep - sp; });
+        return total;
+    }
+
+    // text position of the suffix at bwt position i, walks backwards until it hits a sampled position
+    uint64_t locate(uint64_t i) const {
+        uint64_t steps = 0;
+        while (true) {
+            auto const& block = blocks[i / flat_fm_block_size];
+            size_t offset = i % flat_fm_block_size;
+            auto const& p = block.planes[offset / 64];
+            if ((p[flat_fm_sampled_plane] >> (offset % 64)) & 1) {
+                uint64_t rank = block.occ[flat_fm_sigma]
+                              + block_rank(block, offset, [](uint64_t const* q) { return q[flat_fm_sampled_plane]; });
+                return samples[rank] + steps;
+            }
+            uint8_t c = bwt(i);
+            i = header->C[c] + occ(c, i);
+            steps++;
+        }
+    }
+
+    // sequence and offset inside of it of a text position, the sequence may be a reverse complement
+    sequence_position to_sequence_position(uint64_t text_position) const {
+        return sequence_boundaries{starts, header->sequence_count}.to_sequence_position(text_position);
+    }
+
+    // an occurrence of `length` symbols on a reverse complement is one of their reverse complement on the
+    // sequence it was made of, returns that sequence and the offset of the occurrence there
+    sequence_position forward_position(sequence_position on_reverse, uint64_t length) const {
+        uint64_t id = on_reverse.sequence_id - sequence_count();
+        return {id, sequence_length(id) - on_reverse.offset - length};
+    }
+};
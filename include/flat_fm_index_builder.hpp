@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "flat_fm_index.hpp"
+#include "packed_reference.hpp"
+#include "strand.hpp"
+#include "suffix_sort.hpp"
+
+// the text of a flat fm-index under construction, sequences are appended one at a time,
+// so the reference never has to be held in any other form
+struct flat_fm_text {
+    std::vector<sauchar_t> symbols; // every sequence terminated by the separator 0
+    std::vector<uint64_t> starts;   // start of every sequence in symbols
+    packed_reference packed;        // the sequences without separators
+    bool reverse_complement = false;
+
+    template <typename sequence_t>
+    void append(sequence_t const& sequence) {
+        starts.push_back(symbols.size());
+        for (auto c : sequence) {
+            symbols.push_back(flat_fm_code(c));
+        }
+        symbols.push_back(0);
+        packed.append(sequence);
+    }
+
+    // appends the reverse complement of every sequence, after the last one has been appended; the text
+    // doubles, the packed sequences stay as they are
+    void append_reverse_complements() {
+        size_t const count = starts.size();
+        uint64_t const length = symbols.size();
+        symbols.reserve(2 * length);
+        for (size_t id = 0; id < count; ++id) {
+            starts.push_back(symbols.size());
+            uint64_t begin = starts[id];
+            uint64_t end = (id + 1 < count ? starts[id + 1] : length) - 1; // the separator of sequence id
+            for (uint64_t i = end; i > begin; --i) {
+                symbols.push_back(dna5_rank_complement[symbols[i - 1] - 1] + 1);
+            }
+            symbols.push_back(0);
+        }
+        reverse_complement = true;
+    }
+};
+
+// writes the bwt blocks of a text whose suffix array values arrive in order
+class flat_fm_block_writer {
+    std::ostream& os_;
+    std::vector<sauchar_t> const& text_;
+    uint64_t sa_sample_rate_;
+    uint64_t occ_[8]{};      // occurrences before the next bwt position
+    flat_fm_block block_{}; // block of the next bwt position
+    uint64_t position_ = 0;
+    uint64_t written_ = 0;
+
+public:
+    std::vector<uint64_t> samples;
+
+    flat_fm_block_writer(std::ostream& os, std::vector<sauchar_t> const& text, uint64_t sa_sample_rate)
+        : os_{os}, text_{text}, sa_sample_rate_{sa_sample_rate} {}
+
+    void push(uint64_t sa) {
+        size_t j = position_ % flat_fm_block_size;
+        if (j == 0) {
+            block_ = flat_fm_block{};
+            std::memcpy(block_.occ, occ_, sizeof(occ_));
+        }
+        uint8_t c = text_[sa == 0 ? text_.size() - 1 : sa - 1];
+        for (size_t bit = 0; bit < 3; ++bit) {
+            block_.planes[j / 64][bit] |= uint64_t{(c >> bit) & 1u} << (j % 64);
+        }
+        occ_[c]++;
+        if (sa % sa_sample_rate_ == 0 || c == 0) {
+            block_.planes[j / 64][flat_fm_sampled_plane] |= uint64_t{1} << (j % 64);
+            occ_[flat_fm_sigma]++;
+            samples.push_back(sa);
+        }
+        if (j + 1 == flat_fm_block_size) {
+            os_.write(reinterpret_cast<char const*>(&block_), sizeof(block_));
+            written_++;
+        }
+        position_++;
+    }
+
+    // writes the last, partially filled block and empty blocks up to block_count
+    void finish(uint64_t block_count) {
+        if (position_ % flat_fm_block_size != 0) {
+            os_.write(reinterpret_cast<char const*>(&block_), sizeof(block_));
+            written_++;
+        }
+        for (; written_ < block_count; ++written_) {
+            block_ = flat_fm_block{};
+            std::memcpy(block_.occ, occ_, sizeof(occ_));
+            os_.write(reinterpret_cast<char const*>(&block_), sizeof(block_));
+        }
+    }
+};
+
+// builds a flat fm-index over `text` and writes it to `path`, every sa_sample_rate-th text position is sampled for locate;
+// sort_memory (bytes, 0 for no limit) limits the workspace of the suffix sort: if the whole suffix array does not fit,
+// it is sorted in buckets using `threads` threads, whose tables and positions stay within sort_memory. The text, the
+// packed sequences, the samples and the output buffers come on top of it
+inline void build_flat_fm_index(flat_fm_text const& text, std::filesystem::path const& path, uint64_t sa_sample_rate = 16,
+                                uint64_t sort_memory = 0, size_t threads = 1) {
+    if (sa_sample_rate == 0) {
+        throw std::runtime_error("the suffix array sample rate must be at least 1");
+    }
+
+    auto const& symbols = text.symbols;
+    std::vector<uint64_t> starts = text.starts;
+    starts.push_back(symbols.size());
+    auto const& packed = text.packed;
+
+    flat_fm_header header{};
+    std::memcpy(header.magic, flat_fm_magic, sizeof(flat_fm_magic));
+    header.version = flat_fm_version;
+    header.header_size = sizeof(flat_fm_header);
+    header.text_length = symbols.size();
+    header.sequence_count = starts.size() - 1;
+    header.block_count = symbols.size() / flat_fm_block_size + 1;
+    header.blocks_offset = sizeof(flat_fm_header);
+    header.sequence_starts_offset = header.blocks_offset + header.block_count * sizeof(flat_fm_block);
+    header.sa_sample_rate = sa_sample_rate;
+    for (auto c : symbols) {
+        header.C[c + 1]++;
+    }
+    for (size_t c = 1; c <= flat_fm_sigma; ++c) {
+        header.C[c] += header.C[c - 1];
+    }
+
+    std::ofstream os{path, std::ios::binary};
+    if (!os) {
+        throw std::runtime_error("could not open " + path.string() + " for writing");
+    }
+    // the header is rewritten once the number of samples is known
+    os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    // stream the bwt block by block, so only one block and the samples are held in memory next to the suffix array
+    flat_fm_block_writer writer{os, symbols, sa_sample_rate};
+    writer.samples.reserve(symbols.size() / sa_sample_rate + starts.size());
+    auto build = [&](auto sa_value) {
+        using sa_value_t = decltype(sa_value);
+        uint64_t const n = symbols.size();
+        if (sort_memory == 0 || n * sizeof(sa_value_t) <= sort_memory) {
+            for (auto sa : suffix_sort<sa_value_t>(symbols)) {
+                writer.push(sa);
+            }
+        } else {
+            bucketed_suffix_sort<sa_value_t>(symbols, flat_fm_sigma, sort_memory, threads,
+                                             [&](sa_value_t const* begin, sa_value_t const* end) {
+                for (auto it = begin; it != end; ++it) {
+                    writer.push(*it);
+                }
+            });
+        }
+    };
+    if (needs_64bit_suffix_array(symbols.size())) {
+        build(saidx64_t{});
+    } else {
+        build(saidx_t{});
+    }
+    writer.finish(header.block_count);
+    auto const& samples = writer.samples;
+
+    header.sample_count = samples.size();
+    header.samples_offset = header.sequence_starts_offset + padded_to_64(starts.size() * sizeof(uint64_t));
+    header.words_offset = header.samples_offset + padded_to_64(samples.size() * sizeof(uint64_t));
+    header.runs_offset = header.words_offset + padded_to_64(packed.words().size() * sizeof(uint64_t));
+    header.run_count = packed.runs().size();
+    header.reverse_complement = text.reverse_complement;
+
+    write_padded(os, starts.data(), starts.size() * sizeof(uint64_t));
+    write_padded(os, samples.data(), samples.size() * sizeof(uint64_t));
+    write_padded(os, packed.words().data(), packed.words().size() * sizeof(uint64_t));
+    write_padded(os, packed.runs().data(), packed.runs().size() * sizeof(n_run));
+    os.seekp(0);
+    os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    if (!os) {
+        throw std::runtime_error("failed writing " + path.string());
+    }
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#include <seqan3/io/exception.hpp>
+#include <seqan3/io/sequence_file/all.hpp>
+
+#include "bounded_queue.hpp"
+
+// Decompresses sequence files on background threads.
+// BGZF files (gzip members of at most 64 KiB with a BC extra field, as written by bgzip) are split into
+// batches of blocks that are inflated in parallel. Any other gzip file is inflated on one thread that runs
+// ahead of the parser, uncompressed files are read ahead the same way.
+
+inline constexpr size_t gzip_input_chunk_size = 1 << 20;
+inline constexpr size_t bgzf_batch_blocks = 64;
+// a single parser consumes the inflated text, a few threads inflate faster than it parses
+inline constexpr size_t bgzf_default_max_threads = 4;
+
+// inflate threads of a bgzf file if the caller does not pass its own thread count
+inline size_t default_inflate_threads() {
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 1, bgzf_default_max_threads);
+}
+
+// size of the bgzf block whose first 12 + xlen header bytes are at data, 0 if it is no bgzf block
+inline size_t bgzf_block_size(unsigned char const* data, size_t header_bytes) {
+    if (header_bytes < 12 || data[0] != 31 || data[1] != 139 || data[2] != 8 || !(data[3] & 4)) return 0;
+    size_t xlen = data[10] | (data[11] << 8);
+    if (header_bytes < 12 + xlen) return 0;
+    for (size_t i = 12; i + 4 <= 12 + xlen; i += 4 + (data[i + 2] | (data[i + 3] << 8))) {
+        if (data[i] == 'B' && data[i + 1] == 'C' && (data[i + 2] | (data[i + 3] << 8)) == 2 && i + 6 <= 12 + xlen) {
+            return (data[i + 4] | (data[i + 5] << 8)) + 1;
+        }
+    }
+    return 0;
+}
+
+// streambuf over the decompressed content of a file
+class gzip_streambuf : public std::streambuf {
+    std::ifstream file_;
+    bounded_queue<std::pair<size_t, std::string>> compressed_;
+    bounded_queue<std::pair<size_t, std::string>> inflated_;
+    std::map<size_t, std::string> pending_; // inflated chunks that arrived before their predecessors
+    std::string current_;
+    size_t next_ = 0;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> running_ = 0;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+
+    // runs one stage, an exception cancels all stages and is rethrown to the reader
+    template <typename fn_t>
+    void guarded(fn_t&& fn) {
+        try {
+            fn();
+        } catch (...) {
+            {
+                std::lock_guard lock{error_mutex_};
+                if (!error_) error_ = std::current_exception();
+            }
+            compressed_.cancel();
+            inflated_.cancel();
+        }
+    }
+
+    // reads up to n bytes, fewer only at the end of the file
+    size_t read(char* data, size_t n) {
+        file_.read(data, n);
+        return file_.gcount();
+    }
+
+    // cuts the file into batches of whole bgzf blocks
+    void read_bgzf_batches() {
+        std::array<unsigned char, 65536 + 1> block;
+        for (size_t index = 0;; ++index) {
+            std::string batch;
+            for (size_t b = 0; b < bgzf_batch_blocks; ++b) {
+                size_t got = read(reinterpret_cast<char*>(block.data()), 12);
+                if (got == 0) break;
+                size_t xlen = got == 12 ? block[10] | (block[11] << 8) : 0;
+                got += read(reinterpret_cast<char*>(block.data()) + 12, xlen);
+                size_t size = bgzf_block_size(block.data(), got);
+                if (size == 0 || size < got) {
+                    throw std::runtime_error("corrupt bgzf block");
+                }
+                if (read(reinterpret_cast<char*>(block.data()) + got, size - got) != size - got) {
+                    throw std::runtime_error("truncated bgzf block");
+                }
+                batch.append(reinterpret_cast<char const*>(block.data()), size);
+            }
+            if (batch.empty() || !compressed_.push({index, std::move(batch)})) return;
+        }
+    }
+
+    // inflates every block of a batch, the blocks are complete gzip members
+    static std::string inflate_bgzf_batch(std::string const& batch) {
+        std::string out;
+        auto data = reinterpret_cast<unsigned char const*>(batch.data());
+        for (size_t pos = 0; pos < batch.size();) {
+            size_t size = bgzf_block_size(data + pos, batch.size() - pos);
+            size_t xlen = data[pos + 10] | (data[pos + 11] << 8);
+            unsigned char const* trailer = data + pos + size - 8;
+            uint32_t crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (uint32_t{trailer[3]} << 24);
+            uint32_t isize = trailer[4] | (trailer[5] << 8) | (trailer[6] << 16) | (uint32_t{trailer[7]} << 24);
+
+            size_t offset = out.size();
+            out.resize(offset + isize);
+            z_stream z{};
+            if (inflateInit2(&z, -MAX_WBITS) != Z_OK) throw std::runtime_error("inflateInit2 failed");
+            z.next_in = const_cast<unsigned char*>(data + pos + 12 + xlen);
+            z.avail_in = size - 12 - xlen - 8;
+            z.next_out = reinterpret_cast<unsigned char*>(out.data() + offset);
+            z.avail_out = isize;
+            int status = inflate(&z, Z_FINISH);
+            inflateEnd(&z);
+            if (status != Z_STREAM_END || z.avail_out != 0) {
+                throw std::runtime_error("corrupt bgzf block");
+            }
+            if (crc32(0, reinterpret_cast<unsigned char const*>(out.data() + offset), isize) != crc) {
+                throw std::runtime_error("bgzf block fails its crc check");
+            }
+            pos += size;
+        }
+        return out;
+    }
+
+    // inflates one or more concatenated gzip members sequentially
+    void inflate_gzip_stream() {
+        std::vector<unsigned char> in(gzip_input_chunk_size);
+        z_stream z{};
+        if (inflateInit2(&z, MAX_WBITS + 32) != Z_OK) throw std::runtime_error("inflateInit2 failed");
+        std::unique_ptr<z_stream, decltype(&inflateEnd)> guard{&z, &inflateEnd};
+        for (size_t index = 0;; ++index) {
+            std::string out(gzip_input_chunk_size, '\0');
+            z.next_out = reinterpret_cast<unsigned char*>(out.data());
+            z.avail_out = out.size();
+            bool done = false;
+            while (z.avail_out > 0 && !done) {
+                if (z.avail_in == 0) {
+                    z.next_in = in.data();
+                    z.avail_in = read(reinterpret_cast<char*>(in.data()), in.size());
+                    if (z.avail_in == 0) {
+                        throw std::runtime_error("truncated gzip stream");
+                    }
+                }
+                int status = inflate(&z, Z_NO_FLUSH);
+                if (status == Z_STREAM_END) {
+                    // another member may follow, anything else after the end is ignored
+                    if (z.avail_in == 0) {
+                        z.next_in = in.data();
+                        z.avail_in = read(reinterpret_cast<char*>(in.data()), in.size());
+                    }
+                    if (z.avail_in == 0 || z.next_in[0] != 31) {
+                        done = true;
+                    } else {
+                        inflateReset(&z);
+                    }
+                } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                    throw std::runtime_error("corrupt gzip stream");
+                }
+            }
+            out.resize(out.size() - z.avail_out);
+            if (!inflated_.push({index, std::move(out)}) || done) return;
+        }
+    }
+
+    void read_plain() {
+        for (size_t index = 0;; ++index) {
+            std::string out(gzip_input_chunk_size, '\0');
+            out.resize(read(out.data(), out.size()));
+            if (out.empty() || !inflated_.push({index, std::move(out)})) return;
+        }
+    }
+
+protected:
+    int_type underflow() override {
+        while (true) {
+            if (auto it = pending_.find(next_); it != pending_.end()) {
+                current_ = std::move(it->second);
+                pending_.erase(it);
+                ++next_;
+                if (current_.empty()) continue;
+                setg(current_.data(), current_.data(), current_.data() + current_.size());
+                return traits_type::to_int_type(*gptr());
+            }
+            auto chunk = inflated_.pop();
+            if (!chunk) {
+                std::lock_guard lock{error_mutex_};
+                if (error_) std::rethrow_exception(error_);
+                return traits_type::eof();
+            }
+            pending_.insert(std::move(*chunk));
+        }
+    }
+
+public:
+    // threads only matters for bgzf files
+    explicit gzip_streambuf(std::filesystem::path const& path, size_t threads = default_inflate_threads())
+        : file_{path, std::ios::binary}
+        , compressed_{2 * std::max<size_t>(1, threads)}
+        , inflated_{2 * std::max<size_t>(1, threads)} {
+        if (!file_) {
+            throw std::runtime_error("could not open " + path.string());
+        }
+        threads = std::max<size_t>(1, threads);
+
+        std::array<unsigned char, 65536 + 12> header{};
+        file_.read(reinterpret_cast<char*>(header.data()), 12);
+        size_t got = file_.gcount();
+        if (got == 12) {
+            file_.read(reinterpret_cast<char*>(header.data()) + 12, header[10] | (header[11] << 8));
+            got += file_.gcount();
+        }
+        bool const gzip = got >= 2 && header[0] == 31 && header[1] == 139;
+        bool const bgzf = bgzf_block_size(header.data(), got) != 0;
+        file_.clear();
+        file_.seekg(0);
+
+        if (bgzf) {
+            running_ = threads;
+            threads_.emplace_back([this]() {
+                guarded([this]() { read_bgzf_batches(); });
+                compressed_.close();
+            });
+            for (size_t t = 0; t < threads; ++t) {
+                threads_.emplace_back([this]() {
+                    guarded([this]() {
+                        while (auto batch = compressed_.pop()) {
+                            if (!inflated_.push({batch->first, inflate_bgzf_batch(batch->second)})) break;
+                        }
+                    });
+                    if (--running_ == 0) inflated_.close();
+                });
+            }
+        } else if (gzip) {
+            threads_.emplace_back([this]() {
+                guarded([this]() { inflate_gzip_stream(); });
+                inflated_.close();
+            });
+        } else {
+            threads_.emplace_back([this]() {
+                guarded([this]() { read_plain(); });
+                inflated_.close();
+            });
+        }
+    }
+
+    gzip_streambuf(gzip_streambuf const&) = delete;
+    gzip_streambuf& operator=(gzip_streambuf const&) = delete;
+
+    // the reader may stop early, the stages are cancelled then
+    ~gzip_streambuf() override {
+        compressed_.cancel();
+        inflated_.cancel();
+        for (auto& t : threads_) {
+            t.join();
+        }
+    }
+};
+
+// a sequence file read through a gzip_streambuf, iterated like a seqan3::sequence_file_input
+// the format is detected as seqan3 detects it when opening a path: by the extension of the file name without
+// .gz/.bgz/.bgzf, looked up in the extensions of every format sequence_file_input reads (fasta, fastq, embl,
+// genbank, sam); an unknown extension throws seqan3::unhandled_extension_error
+class sequence_input {
+    std::unique_ptr<gzip_streambuf> buffer_;
+    std::unique_ptr<std::istream> stream_;
+    seqan3::sequence_file_input<> file_;
+
+    template <template <typename...> typename list_t, typename format_t, typename... formats_t>
+    static seqan3::sequence_file_input<> open_as(std::istream& stream, std::filesystem::path const& path,
+                                                 std::string const& extension, list_t<format_t, formats_t...>) {
+        auto const& extensions = format_t::file_extensions;
+        if (std::find(extensions.begin(), extensions.end(), extension) != extensions.end()) {
+            return seqan3::sequence_file_input<>{stream, format_t{}};
+        }
+        if constexpr (sizeof...(formats_t) == 0) {
+            throw seqan3::unhandled_extension_error{"no sequence file format reads the extension of " + path.string()};
+        } else {
+            return open_as(stream, path, extension, list_t<formats_t...>{});
+        }
+    }
+
+    static seqan3::sequence_file_input<> open(std::istream& stream, std::filesystem::path const& path) {
+        // decompression errors surface as exceptions instead of a silently shortened file
+        stream.exceptions(std::ios::badbit);
+        auto name = path;
+        if (name.extension() == ".gz" || name.extension() == ".bgz" || name.extension() == ".bgzf") {
+            name = name.stem();
+        }
+        std::string extension = name.extension().string();
+        if (!extension.empty()) extension.erase(0, 1);
+        return open_as(stream, path, extension, typename seqan3::sequence_file_input<>::valid_formats{});
+    }
+
+public:
+    explicit sequence_input(std::filesystem::path const& path, size_t threads = default_inflate_threads())
+        : buffer_{std::make_unique<gzip_streambuf>(path, threads)}
+        , stream_{std::make_unique<std::istream>(buffer_.get())}
+        , file_{open(*stream_, path)} {}
+
+    auto begin() { return file_.begin(); }
+    auto end() { return file_.end(); }
+};
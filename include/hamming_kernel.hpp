@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+#include "packed_reference.hpp"
+
+// Bit-parallel hamming distance between a query and a window of a packed_reference_view.
+// Both sides are compared as 64-bit words of 32 bases: one word with the 2-bit codes and one word
+// with a 01 lane for every N. A base mismatches if its code lanes or its N lanes differ.
+
+inline constexpr uint64_t hamming_low_lanes = 0x5555555555555555ull;
+
+// number of mismatching bases over `words` words of codes and N lanes
+inline size_t hamming_words_scalar(uint64_t const* query_codes, uint64_t const* query_ns,
+                                   uint64_t const* text_codes, uint64_t const* text_ns, size_t words) {
+    size_t count = 0;
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t x = query_codes[w] ^ text_codes[w];
+        uint64_t m = ((x | (x >> 1)) & hamming_low_lanes) | (query_ns[w] ^ text_ns[w]);
+        count += __builtin_popcountll(m);
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 4 words per step, popcount through a nibble lookup table since AVX2 has no 64-bit popcount
+__attribute__((target("avx2")))
+inline size_t hamming_words_avx2(uint64_t const* query_codes, uint64_t const* query_ns,
+                                 uint64_t const* text_codes, uint64_t const* text_ns, size_t words) {
+    __m256i const lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    __m256i const low_nibbles = _mm256_set1_epi8(0x0f);
+    __m256i const low_lanes = _mm256_set1_epi64x(static_cast<long long>(hamming_low_lanes));
+    __m256i acc = _mm256_setzero_si256();
+    size_t w = 0;
+    for (; w + 4 <= words; w += 4) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(query_codes + w)),
+                                     _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text_codes + w)));
+        __m256i n = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(query_ns + w)),
+                                     _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text_ns + w)));
+        __m256i m = _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 1)), low_lanes), n);
+        __m256i lo = _mm256_and_si256(m, low_nibbles);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(m, 4), low_nibbles);
+        __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+    size_t count = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+                 + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+    return count + hamming_words_scalar(query_codes + w, query_ns + w, text_codes + w, text_ns + w, words - w);
+}
+
+// 8 words per step, the tail is handled with masked loads
+__attribute__((target("avx512f,avx512vpopcntdq")))
+inline size_t hamming_words_avx512(uint64_t const* query_codes, uint64_t const* query_ns,
+                                   uint64_t const* text_codes, uint64_t const* text_ns, size_t words) {
+    __m512i const low_lanes = _mm512_set1_epi64(static_cast<long long>(hamming_low_lanes));
+    __m512i acc = _mm512_setzero_si512();
+    for (size_t w = 0; w < words; w += 8) {
+        __mmask8 k = words - w >= 8 ? 0xff : static_cast<__mmask8>((1u << (words - w)) - 1);
+        __m512i x = _mm512_xor_si512(_mm512_maskz_loadu_epi64(k, query_codes + w), _mm512_maskz_loadu_epi64(k, text_codes + w));
+        __m512i m = _mm512_and_si512(_mm512_or_si512(x, _mm512_maskz_srli_epi64(0xff, x, 1)), low_lanes);
+        m = _mm512_or_si512(m, _mm512_xor_si512(_mm512_maskz_loadu_epi64(k, query_ns + w), _mm512_maskz_loadu_epi64(k, text_ns + w)));
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(m));
+    }
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512(lanes, acc);
+    size_t count = 0;
+    for (auto lane : lanes) count += lane;
+    return count;
+}
+#endif
+
+using hamming_words_fn = size_t (*)(uint64_t const*, uint64_t const*, uint64_t const*, uint64_t const*, size_t);
+
+// widest kernel the running cpu supports
+inline hamming_words_fn select_hamming_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq")) return hamming_words_avx512;
+    if (__builtin_cpu_supports("avx2")) return hamming_words_avx2;
+#endif
+    return hamming_words_scalar;
+}
+
+inline hamming_words_fn const hamming_kernel = select_hamming_kernel();
+
+// Packs one query at a time and counts its mismatches against text windows.
+// The buffers are reused, so after the longest query has been seen no call allocates.
+class hamming_verifier {
+    // words compared before checking the limit
+    static constexpr size_t chunk_words = 8;
+
+    std::vector<uint64_t> query_codes_;
+    std::vector<uint64_t> query_ns_;
+    std::vector<uint64_t> text_codes_;
+    std::vector<uint64_t> text_ns_;
+    size_t length_ = 0;
+
+public:
+    template <typename query_t>
+    void set_query(query_t const& query) {
+        length_ = query.size();
+        size_t words = (length_ + 31) / 32;
+        query_codes_.assign(words, 0);
+        query_ns_.assign(words, 0);
+        text_codes_.resize(words);
+        text_ns_.resize(words);
+        for (size_t j = 0; j < length_; ++j) {
+            auto r = seqan3::to_rank(query[j]);
+            uint64_t shift = 2 * (j % 32);
+            query_codes_[j / 32] |= uint64_t{dna5_rank_to_code[r]} << shift;
+            query_ns_[j / 32] |= uint64_t{r == dna5_rank_n} << shift;
+        }
+    }
+
+    // number of mismatches between the query and the text starting at pos, counting stops once limit is exceeded;
+    // pos + query length must not exceed text.size()
+    size_t mismatches(packed_reference_view const& text, uint64_t pos, size_t limit) {
+        size_t words = query_codes_.size();
+        if (words == 0) return 0;
+        for (size_t w = 0; w < words; ++w) {
+            text_codes_[w] = text.codes_at(pos + 32 * w);
+        }
+        if (length_ % 32) {
+            text_codes_[words - 1] &= (uint64_t{1} << (2 * (length_ % 32))) - 1;
+        }
+        std::fill(text_ns_.begin(), text_ns_.end(), 0);
+        uint64_t end = pos + length_;
+        for (auto run = text.next_run(pos); run != text.runs + text.run_count && run->begin < end; ++run) {
+            for (uint64_t j = std::max(run->begin, pos) - pos; j < std::min(run->end, end) - pos; ++j) {
+                text_ns_[j / 32] |= uint64_t{1} << (2 * (j % 32));
+            }
+        }
+        size_t count = 0;
+        for (size_t w = 0; w < words && count <= limit; w += chunk_words) {
+            size_t n = std::min(chunk_words, words - w);
+            count += hamming_kernel(query_codes_.data() + w, query_ns_.data() + w, text_codes_.data() + w, text_ns_.data() + w, n);
+        }
+        return count;
+    }
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+#include "strand.hpp"
+
+// Per-query hit output of the search tools.
+// Every search thread formats its hits into its own buffer, the buffers of whole query chunks are written in
+// order by one thread through a large file buffer. Reference sequences are named by their number in the
+// reference file, positions are 0-based in tsv and 1-based in sam.
+//
+//   tsv: read id, reference sequence, position, strand, errors ("*" if the engine does not report them)
+//   sam: unpaired records without qualities, NM holds the errors, CIGAR is only given for hamming hits
+
+enum class hit_format { tsv, sam };
+
+inline hit_format parse_hit_format(std::string const& name) {
+    if (name == "tsv") return hit_format::tsv;
+    if (name == "sam") return hit_format::sam;
+    throw std::runtime_error("unknown output format " + name + ", expected tsv or sam");
+}
+
+inline constexpr size_t hit_unknown_errors = std::numeric_limits<size_t>::max();
+
+struct hit {
+    uint64_t sequence_id;
+    uint64_t position;  // first reference position of the alignment inside of the sequence
+    char strand;        // '+' or '-'
+    size_t errors;      // hit_unknown_errors if not known
+    bool gapped;        // edit distance hits may contain indels and get no CIGAR
+};
+
+// receives the hits of the searched queries
+class hit_sink {
+public:
+    virtual ~hit_sink() = default;
+
+    // query is the element of the searched chunk's queries the hit belongs to
+    virtual void add(std::string_view read_id, std::vector<seqan3::dna5> const& query, hit const& h) = 0;
+};
+
+// formats hits into a reusable buffer, one formatter per thread
+class hit_formatter : public hit_sink {
+    hit_format format_;
+    std::string buffer_;
+
+    void append_number(uint64_t value) {
+        char digits[20];
+        auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        buffer_.append(digits, end);
+    }
+
+    template <typename query_t>
+    void append_sequence(query_t const& query, bool reverse) {
+        static constexpr char letters[5]{'A', 'C', 'G', 'N', 'T'};
+        size_t const m = query.size();
+        for (size_t j = 0; j < m; ++j) {
+            auto r = seqan3::to_rank(query[reverse ? m - 1 - j : j]);
+            buffer_.push_back(letters[reverse ? dna5_rank_complement[r] : r]);
+        }
+    }
+
+public:
+    explicit hit_formatter(hit_format format = hit_format::tsv) : format_{format} {}
+
+    // the read id is cut at its first whitespace, as sam requires
+    void add(std::string_view read_id, std::vector<seqan3::dna5> const& query, hit const& h) override {
+        read_id = read_id.substr(0, read_id.find_first_of(" \t"));
+        buffer_.append(read_id);
+        buffer_.push_back('\t');
+        if (format_ == hit_format::tsv) {
+            append_number(h.sequence_id);
+            buffer_.push_back('\t');
+            append_number(h.position);
+            buffer_.push_back('\t');
+            buffer_.push_back(h.strand);
+            buffer_.push_back('\t');
+            if (h.errors == hit_unknown_errors) {
+                buffer_.push_back('*');
+            } else {
+                append_number(h.errors);
+            }
+            buffer_.push_back('\n');
+            return;
+        }
+        buffer_.append(h.strand == '-' ? "16\t" : "0\t");
+        append_number(h.sequence_id);
+        buffer_.push_back('\t');
+        append_number(h.position + 1);
+        buffer_.append("\t255\t");
+        if (h.gapped) {
+            buffer_.push_back('*');
+        } else {
+            append_number(query.size());
+            buffer_.push_back('M');
+        }
+        buffer_.append("\t*\t0\t0\t");
+        // sam stores reverse strand reads as they appear on the forward strand
+        append_sequence(query, h.strand == '-');
+        buffer_.append("\t*");
+        if (h.errors != hit_unknown_errors) {
+            buffer_.append("\tNM:i:");
+            append_number(h.errors);
+        }
+        buffer_.push_back('\n');
+    }
+
+    // hands the formatted hits over in `out` and continues in the buffer `out` held before, cleared; passing in
+    // the buffer of an already written chunk keeps its capacity, so formatting the next chunk does not allocate
+    void swap_buffer(std::string& out) {
+        out.swap(buffer_);
+        buffer_.clear();
+    }
+
+    // hands the formatted hits over and starts a new buffer
+    std::string take() {
+        std::string out;
+        out.swap(buffer_);
+        return out;
+    }
+};
+
+// sam header, with @SQ lines if the sequence lengths are known
+inline std::string sam_header(std::vector<uint64_t> const& sequence_lengths) {
+    std::string header = "@HD\tVN:1.6\tSO:unsorted\n";
+    for (size_t id = 0; id < sequence_lengths.size(); ++id) {
+        header += "@SQ\tSN:" + std::to_string(id) + "\tLN:" + std::to_string(sequence_lengths[id]) + '\n';
+    }
+    return header;
+}
+
+// output file of the hits, written through a large buffer
+class hit_output {
+    static constexpr size_t buffer_size = 1 << 20;
+
+    std::vector<char> buffer_;
+    std::ofstream file_;
+    hit_format format_;
+
+public:
+    hit_output(std::filesystem::path const& path, hit_format format) : buffer_(buffer_size), format_{format} {
+        file_.rdbuf()->pubsetbuf(buffer_.data(), buffer_.size());
+        file_.open(path);
+        if (!file_) {
+            throw std::runtime_error("could not open " + path.string() + " for writing");
+        }
+    }
+
+    hit_output(hit_output const&) = delete;
+    hit_output& operator=(hit_output const&) = delete;
+
+    // only sam has a header
+    void write_header(std::vector<uint64_t> const& sequence_lengths = {}) {
+        if (format_ == hit_format::sam) file_ << sam_header(sequence_lengths);
+    }
+
+    std::ostream& stream() { return file_; }
+};
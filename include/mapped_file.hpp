@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// read-only memory mapping of a whole file
+// pages are shared through the page cache, so several processes mapping the same file only pay for it once
+class mapped_file {
+    void const* addr = nullptr;
+    size_t length = 0;
+
+public:
+    mapped_file() = default;
+
+    explicit mapped_file(std::filesystem::path const& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("could not open " + path.string());
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("could not stat " + path.string());
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            addr = nullptr;
+            throw std::runtime_error("could not mmap " + path.string());
+        }
+    }
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    mapped_file(mapped_file&& other) noexcept
+        : addr{std::exchange(other.addr, nullptr)}, length{std::exchange(other.length, 0)} {}
+
+    mapped_file& operator=(mapped_file&& other) noexcept {
+        std::swap(addr, other.addr);
+        std::swap(length, other.length);
+        return *this;
+    }
+
+    ~mapped_file() {
+        if (addr != nullptr) {
+            ::munmap(const_cast<void*>(addr), length);
+        }
+    }
+
+    // hint the kernel about the expected access pattern (e.g. MADV_RANDOM for index lookups)
+    void advise(int advice) const {
+        if (addr != nullptr) {
+            ::madvise(const_cast<void*>(addr), length, advice);
+        }
+    }
+
+    std::byte const* data() const { return static_cast<std::byte const*>(addr); }
+    size_t size() const { return length; }
+};
+
+// sections of mmap-able files start at multiples of 64 bytes
+inline uint64_t padded_to_64(uint64_t bytes) {
+    return (bytes + 63) / 64 * 64;
+}
+
+inline void write_padded(std::ostream& os, void const* data, uint64_t bytes) {
+    static constexpr char zeros[64]{};
+    os.write(static_cast<char const*>(data), bytes);
+    os.write(zeros, padded_to_64(bytes) - bytes);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+#include "packed_reference.hpp"
+
+// Myers' bit-vector edit distance (J. ACM 1999) with Hyyrö's block formulation for queries longer than 64.
+// The query must be aligned completely, its start and end inside of the text window are free.
+// Blocks below the last one that can still reach a score <= limit are not computed (Ukkonen cut-off),
+// so only a band of the dp matrix around the alignment diagonal is evaluated.
+
+// best alignment of the query inside of a text window
+struct edit_alignment {
+    size_t errors; // limit + 1 if there is no alignment within the limit
+    uint64_t end;  // one past the last text position of the alignment (its first position for alignment_begin)
+};
+
+class myers_verifier {
+    static constexpr size_t block_bits = 64;
+
+    std::vector<uint64_t> peq_;         // match bits of every dna5 rank, 5 words per block
+    std::vector<uint64_t> reverse_peq_; // the same for the reversed query
+    std::vector<uint64_t> pv_;
+    std::vector<uint64_t> mv_;
+    std::vector<size_t> score_;
+    std::vector<uint8_t> window_;
+    size_t length_ = 0;
+    size_t blocks_ = 0;
+
+    // rows of block b
+    size_t block_width(size_t b) const {
+        return b + 1 < blocks_ ? block_bits : length_ - b * block_bits;
+    }
+
+    // advances block b by one text column with match bits eq, returns the horizontal delta leaving its last row
+    int advance_block(size_t b, uint64_t eq, int h_in) {
+        uint64_t pv = pv_[b];
+        uint64_t mv = mv_[b];
+        uint64_t high = uint64_t{1} << (block_width(b) - 1);
+
+        uint64_t xv = eq | mv;
+        if (h_in < 0) eq |= 1;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+
+        int h_out = 0;
+        if (ph & high) h_out = 1;
+        if (mh & high) h_out = -1;
+
+        ph <<= 1;
+        mh <<= 1;
+        if (h_in < 0) mh |= 1;
+        else if (h_in > 0) ph |= 1;
+
+        pv_[b] = mh | ~(xv | ph);
+        mv_[b] = ph & xv;
+        return h_out;
+    }
+
+    void reset_block(size_t b) {
+        pv_[b] = ~uint64_t{0};
+        mv_[b] = 0;
+    }
+
+    // aligns the query with match bits peq against `columns` text columns whose dna5 ranks are returned by
+    // next_rank(), one call per column; the alignment starts anywhere (free) or at the first column (anchored).
+    // returns the best score and the number of columns up to its end, the fewest columns win ties
+    template <typename rank_fn_t>
+    edit_alignment scan(uint64_t const* peq, uint64_t columns, size_t limit, bool anchored, rank_fn_t&& next_rank) {
+        edit_alignment best{limit + 1, columns};
+
+        // blocks that are active from the start: their last row has score <= limit in every column
+        size_t y = std::min(blocks_, std::max<size_t>(1, (limit + block_bits - 1) / block_bits)) - 1;
+        for (size_t b = 0; b <= y; ++b) {
+            reset_block(b);
+            score_[b] = (b ? score_[b - 1] : 0) + block_width(b);
+        }
+
+        // the first row costs nothing with a free start, one per skipped text column with an anchored one
+        int const top = anchored ? 1 : 0;
+        for (uint64_t i = 0; i < columns; ++i) {
+            uint8_t c = next_rank();
+            int carry = top;
+            for (size_t b = 0; b <= y; ++b) {
+                carry = advance_block(b, peq[b * 5 + c], carry);
+                score_[b] += carry;
+            }
+
+            if (y + 1 < blocks_ && score_[y] - carry <= limit && ((peq[(y + 1) * 5 + c] & 1) || carry < 0)) {
+                ++y;
+                reset_block(y);
+                score_[y] = score_[y - 1] + block_width(y) - carry;
+                score_[y] += advance_block(y, peq[y * 5 + c], carry);
+            } else {
+                while (y > 0 && score_[y] >= limit + block_width(y)) --y;
+            }
+
+            if (y + 1 == blocks_ && score_[y] < best.errors) {
+                best = {score_[y], i + 1};
+            }
+        }
+        return best;
+    }
+
+    edit_alignment forward_alignment(packed_reference_view const& text, uint64_t begin, uint64_t end, size_t limit,
+                                     bool anchored) {
+        if (blocks_ == 0) return {0, begin};
+        uint64_t i = begin;
+        uint64_t n = text.next_n(begin);
+        auto best = scan(peq_.data(), end - begin, limit, anchored, [&]() -> uint8_t {
+            if (i == n) {
+                n = text.next_n(++i);
+                return dna5_rank_n;
+            }
+            return code_to_dna5_rank[text.code(i++)];
+        });
+        return {best.errors, begin + best.end};
+    }
+
+public:
+    // buffers are reused, so after the longest query has been seen no call allocates
+    template <typename query_t>
+    void set_query(query_t const& query) {
+        length_ = query.size();
+        blocks_ = (length_ + block_bits - 1) / block_bits;
+        peq_.assign(blocks_ * 5, 0);
+        reverse_peq_.assign(blocks_ * 5, 0);
+        pv_.resize(blocks_);
+        mv_.resize(blocks_);
+        score_.resize(blocks_);
+        for (size_t j = 0; j < length_; ++j) {
+            peq_[(j / block_bits) * 5 + seqan3::to_rank(query[j])] |= uint64_t{1} << (j % block_bits);
+            reverse_peq_[(j / block_bits) * 5 + seqan3::to_rank(query[length_ - 1 - j])] |= uint64_t{1} << (j % block_bits);
+        }
+    }
+
+    // best alignment of the query ending inside of text[begin, end), the leftmost end wins ties
+    edit_alignment best_alignment(packed_reference_view const& text, uint64_t begin, uint64_t end, size_t limit) {
+        return forward_alignment(text, begin, end, limit, false);
+    }
+
+    // best alignment of the query that begins exactly at begin and ends inside of text[begin, end), the leftmost end
+    // wins ties
+    edit_alignment alignment_end(packed_reference_view const& text, uint64_t begin, uint64_t end, size_t limit) {
+        return forward_alignment(text, begin, end, limit, true);
+    }
+
+    // first text position of the best alignment that ends exactly at end and starts at or after begin, found by
+    // aligning the reversed query leftwards from end; returns the errors of that alignment and its begin
+    edit_alignment alignment_begin(packed_reference_view const& text, uint64_t begin, uint64_t end, size_t limit) {
+        if (blocks_ == 0) return {0, end};
+        window_.resize(end - begin);
+        text.ranks(begin, end, window_.data());
+        uint64_t i = end - begin;
+        auto best = scan(reverse_peq_.data(), end - begin, limit, true, [&]() { return window_[--i]; });
+        return {best.errors, end - best.end};
+    }
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+// A dna5 text stored with 2 bits per base (A=0, C=1, G=2, T=3) plus a sorted list of N runs.
+// N positions hold code 0 in the packed words and are only recognized through the run list.
+struct n_run {
+    uint64_t begin;
+    uint64_t end;
+};
+
+inline constexpr std::array<uint8_t, 5> dna5_rank_to_code{0, 1, 2, 0, 3};
+inline constexpr std::array<uint8_t, 4> code_to_dna5_rank{0, 1, 2, 4};
+inline constexpr uint8_t dna5_rank_n = 3;
+
+// the dna5 ranks of the 4 codes in a byte of a packed word, as 4 bytes in text order
+inline constexpr std::array<uint32_t, 256> packed_byte_to_ranks = [] {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        for (uint32_t j = 0; j < 4; ++j) {
+            table[byte] |= uint32_t{code_to_dna5_rank[(byte >> (2 * j)) & 3]} << (8 * j);
+        }
+    }
+    return table;
+}();
+
+// non-owning view, either on a packed_reference or on a mmap'ed file
+class packed_reference_view {
+public:
+    uint64_t const* words = nullptr;
+    n_run const* runs = nullptr;
+    uint64_t length = 0;
+    uint64_t run_count = 0;
+
+    uint64_t size() const { return length; }
+
+    // 2-bit code of position i, 0 for N
+    uint8_t code(uint64_t i) const {
+        return (words[i / 32] >> (2 * (i % 32))) & 3;
+    }
+
+    // the 32 codes starting at position i, positions past the end read as 0
+    uint64_t codes_at(uint64_t i) const {
+        uint64_t w = i / 32;
+        uint64_t shift = 2 * (i % 32);
+        uint64_t word_count = (length + 31) / 32;
+        uint64_t lo = w < word_count ? words[w] >> shift : 0;
+        uint64_t hi = shift && w + 1 < word_count ? words[w + 1] << (64 - shift) : 0;
+        return lo | hi;
+    }
+
+    // first N run that ends after position i, runs + run_count if there is none
+    n_run const* next_run(uint64_t i) const {
+        return std::partition_point(runs, runs + run_count, [i](n_run const& r) { return r.end <= i; });
+    }
+
+    // first position >= i that holds an N, size() if there is none
+    uint64_t next_n(uint64_t i) const {
+        auto run = next_run(i);
+        if (run == runs + run_count) return length;
+        return std::max(i, run->begin);
+    }
+
+    bool is_n(uint64_t i) const {
+        return next_n(i) == i;
+    }
+
+    // dna5 rank of position i
+    uint8_t rank(uint64_t i) const {
+        return is_n(i) ? dna5_rank_n : code_to_dna5_rank[code(i)];
+    }
+
+    seqan3::dna5 operator[](uint64_t i) const {
+        return seqan3::assign_rank_to(rank(i), seqan3::dna5{});
+    }
+
+    // writes the dna5 ranks of [begin, end) to out
+    void ranks(uint64_t begin, uint64_t end, uint8_t* out) const {
+        uint64_t i = begin;
+        for (; i < end && i % 4 != 0; ++i) {
+            out[i - begin] = code_to_dna5_rank[code(i)];
+        }
+        // 4 codes per table lookup
+        for (; i + 4 <= end; i += 4) {
+            uint32_t four = packed_byte_to_ranks[(words[i / 32] >> (2 * (i % 32))) & 0xff];
+            std::memcpy(out + (i - begin), &four, sizeof(four));
+        }
+        for (; i < end; ++i) {
+            out[i - begin] = code_to_dna5_rank[code(i)];
+        }
+        for (auto run = next_run(begin); run != runs + run_count && run->begin < end; ++run) {
+            std::fill(out + std::max(run->begin, begin) - begin, out + std::min(run->end, end) - begin, dna5_rank_n);
+        }
+    }
+
+    // length of the common prefix of the text starting at pos and query, the first `from` characters are known to match
+    template <typename query_t>
+    size_t lcp(uint64_t pos, query_t const& query, size_t from = 0) const {
+        size_t j = from;
+        uint64_t n = next_n(pos + j);
+        for (; j < query.size() && pos + j < length; ++j) {
+            uint8_t r;
+            if (pos + j == n) {
+                r = dna5_rank_n;
+                n = next_n(pos + j + 1);
+            } else {
+                r = code_to_dna5_rank[code(pos + j)];
+            }
+            if (r != seqan3::to_rank(query[j])) break;
+        }
+        return j;
+    }
+};
+
+// owning, growable packed text
+class packed_reference {
+    std::vector<uint64_t> words_;
+    std::vector<n_run> runs_;
+    uint64_t length_ = 0;
+
+public:
+    void push_back(seqan3::dna5 c) {
+        if (length_ % 32 == 0) {
+            words_.push_back(0);
+        }
+        auto r = seqan3::to_rank(c);
+        words_.back() |= uint64_t{dna5_rank_to_code[r]} << (2 * (length_ % 32));
+        if (r == dna5_rank_n) {
+            if (!runs_.empty() && runs_.back().end == length_) {
+                runs_.back().end++;
+            } else {
+                runs_.push_back({length_, length_ + 1});
+            }
+        }
+        length_++;
+    }
+
+    template <typename sequence_t>
+    void append(sequence_t const& sequence) {
+        for (auto c : sequence) {
+            push_back(c);
+        }
+    }
+
+    uint64_t size() const { return length_; }
+    std::vector<uint64_t> const& words() const { return words_; }
+    std::vector<n_run> const& runs() const { return runs_; }
+
+    packed_reference_view view() const {
+        return {words_.data(), runs_.data(), length_, runs_.size()};
+    }
+};
+
+// sequence and offset inside of it of a position in a concatenated text
+struct sequence_position {
+    uint64_t sequence_id;
+    uint64_t offset;
+};
+
+// Boundary table of the sequences of a concatenated text, non-owning.
+// starts[id] is the first position of sequence id, starts[count] one past the last position of the text.
+class sequence_boundaries {
+public:
+    uint64_t const* starts = nullptr;
+    uint64_t count = 0;
+
+    uint64_t start(uint64_t id) const { return starts[id]; }
+    uint64_t end(uint64_t id) const { return starts[id + 1]; }
+
+    // sequence containing position pos, O(log count)
+    uint64_t sequence_of(uint64_t pos) const {
+        return std::upper_bound(starts, starts + count, pos) - starts - 1;
+    }
+
+    sequence_position to_sequence_position(uint64_t pos) const {
+        uint64_t id = sequence_of(pos);
+        return {id, pos - starts[id]};
+    }
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gzip_input.hpp"
+#include "mapped_file.hpp"
+#include "packed_reference.hpp"
+
+// On-disk layout of a packed reference, every section starts at a multiple of 64 bytes:
+//
+//   [packed_reference_header][packed words][n runs][uint64_t sequence_starts[sequence_count + 1]]
+//
+// The packed text is the concatenation of all reference sequences without separators.
+inline constexpr char packed_reference_magic[8] = {'I', 'S', 'P', 'K', 'R', 'E', 'F', '\0'};
+inline constexpr uint32_t packed_reference_version = 1;
+
+struct alignas(64) packed_reference_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t text_length;
+    uint64_t sequence_count;
+    uint64_t words_offset;
+    uint64_t runs_offset;
+    uint64_t run_count;
+    uint64_t sequence_starts_offset;
+};
+
+static_assert(sizeof(packed_reference_header) % 64 == 0);
+
+inline void save_packed_reference(std::filesystem::path const& path,
+                                  packed_reference_view const& reference,
+                                  std::vector<uint64_t> const& sequence_starts) {
+    packed_reference_header header{};
+    std::memcpy(header.magic, packed_reference_magic, sizeof(packed_reference_magic));
+    header.version = packed_reference_version;
+    header.header_size = sizeof(packed_reference_header);
+    header.text_length = reference.size();
+    header.sequence_count = sequence_starts.size() - 1;
+    header.words_offset = sizeof(packed_reference_header);
+    uint64_t const word_count = (reference.size() + 31) / 32;
+    header.runs_offset = header.words_offset + padded_to_64(word_count * sizeof(uint64_t));
+    header.run_count = reference.run_count;
+    header.sequence_starts_offset = header.runs_offset + padded_to_64(header.run_count * sizeof(n_run));
+
+    std::ofstream os{path, std::ios::binary};
+    if (!os) {
+        throw std::runtime_error("could not open " + path.string() + " for writing");
+    }
+    write_padded(os, &header, sizeof(header));
+    write_padded(os, reference.words, word_count * sizeof(uint64_t));
+    write_padded(os, reference.runs, header.run_count * sizeof(n_run));
+    write_padded(os, sequence_starts.data(), sequence_starts.size() * sizeof(uint64_t));
+    if (!os) {
+        throw std::runtime_error("failed writing " + path.string());
+    }
+}
+
+// true if the file at `path` starts with the packed reference magic
+inline bool is_packed_reference(std::filesystem::path const& path) {
+    std::ifstream is{path, std::ios::binary};
+    char magic[sizeof(packed_reference_magic)]{};
+    is.read(magic, sizeof(magic));
+    return is && std::memcmp(magic, packed_reference_magic, sizeof(magic)) == 0;
+}
+
+// The reference of a search tool, 2 bits per base: mmap'ed from a packed reference file,
+// or read from a sequence file and packed while reading.
+class reference_text {
+    std::optional<mapped_file> file_;
+    packed_reference packed_;
+    std::vector<uint64_t> owned_starts_;
+    packed_reference_view view_;
+    uint64_t const* starts_ = nullptr;
+    uint64_t sequence_count_ = 0;
+
+public:
+    explicit reference_text(std::filesystem::path const& path) {
+        if (is_packed_reference(path)) {
+            file_.emplace(path);
+            if (file_->size() < sizeof(packed_reference_header)) {
+                throw std::runtime_error(path.string() + " is too small to be a packed reference");
+            }
+            auto header = reinterpret_cast<packed_reference_header const*>(file_->data());
+            if (header->version != packed_reference_version || header->header_size != sizeof(packed_reference_header)) {
+                throw std::runtime_error(path.string() + " has unsupported packed reference version "
+                                         + std::to_string(header->version));
+            }
+            if (file_->size() < header->sequence_starts_offset + (header->sequence_count + 1) * sizeof(uint64_t)) {
+                throw std::runtime_error(path.string() + " is truncated");
+            }
+            view_ = {reinterpret_cast<uint64_t const*>(file_->data() + header->words_offset),
+                     reinterpret_cast<n_run const*>(file_->data() + header->runs_offset),
+                     header->text_length,
+                     header->run_count};
+            starts_ = reinterpret_cast<uint64_t const*>(file_->data() + header->sequence_starts_offset);
+            sequence_count_ = header->sequence_count;
+            return;
+        }
+        for (auto& record : sequence_input{path}) {
+            owned_starts_.push_back(packed_.size());
+            packed_.append(record.sequence());
+        }
+        owned_starts_.push_back(packed_.size());
+        view_ = packed_.view();
+        starts_ = owned_starts_.data();
+        sequence_count_ = owned_starts_.size() - 1;
+    }
+
+    reference_text(reference_text const&) = delete;
+    reference_text& operator=(reference_text const&) = delete;
+
+    packed_reference_view const& view() const { return view_; }
+    uint64_t size() const { return view_.size(); }
+
+    uint64_t sequence_count() const { return sequence_count_; }
+    // start of sequence id in the concatenated text, sequence_start(sequence_count()) is size()
+    uint64_t sequence_start(uint64_t id) const { return starts_[id]; }
+    uint64_t sequence_length(uint64_t id) const { return starts_[id + 1] - starts_[id]; }
+    sequence_boundaries boundaries() const { return {starts_, sequence_count_}; }
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// splits [0, n) into one contiguous block per thread and calls fn(thread_id, begin, end) on each block
+// exceptions thrown inside a worker are rethrown on the calling thread after all workers joined
+template <typename fn_t>
+void parallel_blocks(size_t n, size_t threads, fn_t && fn) {
+    threads = std::max<size_t>(1, std::min(threads, n));
+    if (threads == 1) {
+        fn(size_t{0}, size_t{0}, n);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    size_t block = (n + threads - 1) / threads;
+    for (size_t t = 0; t < threads; ++t) {
+        size_t begin = std::min(n, t * block);
+        size_t end   = std::min(n, begin + block);
+        workers.emplace_back([&fn, &errors, t, begin, end]() {
+            try {
+                fn(t, begin, end);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+// calls fn(thread_id, i) for every i in [0, n), threads take the next index as soon as they are done with the previous one
+// exceptions thrown inside a worker are rethrown on the calling thread after all workers joined
+template <typename fn_t>
+void parallel_for_each_index_on_thread(size_t n, size_t threads, fn_t && fn) {
+    std::atomic<size_t> next{0};
+    parallel_blocks(threads, threads, [&](size_t thread_id, size_t, size_t) {
+        for (size_t i = next++; i < n; i = next++) {
+            fn(thread_id, i);
+        }
+    });
+}
+
+// calls fn(i) for every i in [0, n), threads take the next index as soon as they are done with the previous one
+// exceptions thrown inside a worker are rethrown on the calling thread after all workers joined
+template <typename fn_t>
+void parallel_for_each_index(size_t n, size_t threads, fn_t && fn) {
+    parallel_for_each_index_on_thread(n, threads, [&](size_t, size_t i) { fn(i); });
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+// hashes a query packed 3 bits per base, 21 bases to a word
+struct packed_query_hash {
+    size_t operator()(std::vector<seqan3::dna5> const& query) const noexcept {
+        uint64_t hash = query.size();
+        uint64_t word = 0;
+        size_t filled = 0;
+        auto mix = [&] {
+            // splitmix64 finalizer over the running hash and the next word
+            uint64_t z = hash ^ (word + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            hash = z ^ (z >> 31);
+            word = 0;
+            filled = 0;
+        };
+        for (auto base : query) {
+            word |= uint64_t{seqan3::to_rank(base)} << (3 * filled);
+            if (++filled == 21) mix();
+        }
+        if (filled != 0) mix();
+        return hash;
+    }
+
+    size_t operator()(std::vector<seqan3::dna5> const* query) const noexcept { return (*this)(*query); }
+};
+
+// compares queries held by pointer, so a chunk can be deduplicated without copying its queries
+struct query_pointer_equal {
+    bool operator()(std::vector<seqan3::dna5> const* a, std::vector<seqan3::dna5> const* b) const {
+        return *a == *b;
+    }
+};
+
+// the capacity most recently used queries and their results
+template <typename value_t>
+class query_lru_cache {
+    using entry = std::pair<std::vector<seqan3::dna5>, value_t>;
+
+    size_t capacity_;
+    std::list<entry> entries_; // most recently used first
+    // keys point into entries_, list nodes do not move
+    std::unordered_map<std::vector<seqan3::dna5> const*, typename std::list<entry>::iterator,
+                       packed_query_hash, query_pointer_equal> index_;
+
+public:
+    explicit query_lru_cache(size_t capacity) : capacity_{capacity} {
+        index_.reserve(capacity);
+    }
+
+    // the cached value of query or null, a found entry becomes the most recently used
+    value_t const* find(std::vector<seqan3::dna5> const& query) {
+        auto found = index_.find(&query);
+        if (found == index_.end()) return nullptr;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        return &found->second->second;
+    }
+
+    // stores value for query, replacing an older value and evicting the least recently used entry if full
+    void put(std::vector<seqan3::dna5> const& query, value_t value) {
+        if (capacity_ == 0) return;
+        if (auto found = index_.find(&query); found != index_.end()) {
+            found->second->second = std::move(value);
+            entries_.splice(entries_.begin(), entries_, found->second);
+            return;
+        }
+        if (entries_.size() == capacity_) {
+            index_.erase(&entries_.back().first);
+            entries_.pop_back();
+        }
+        entries_.emplace_front(query, std::move(value));
+        index_.emplace(&entries_.front().first, entries_.begin());
+    }
+
+    size_t size() const { return entries_.size(); }
+};
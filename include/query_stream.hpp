@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+#include "bounded_queue.hpp"
+#include "gzip_input.hpp"
+
+// Streams a query file through a search in fixed-size chunks, so memory does not grow with the number of reads:
+// a reader thread parses chunks, worker threads search them and the calling thread writes their output.
+// The stages are connected by bounded queues.
+
+inline constexpr size_t query_chunk_size = 1024;
+
+struct query_chunk {
+    size_t index;       // position of the chunk in the stream
+    size_t first_query; // number of the first query of the chunk
+    std::vector<std::vector<seqan3::dna5>> queries;
+    std::vector<std::string> ids; // read id of every query
+};
+
+// pushes the queries of query_file in chunks of chunk_size, the file is read again from its start until limit
+// queries were produced; returns early if the queue is closed. A bgzf file is inflated on up to `threads` threads
+// each time it is read
+inline void read_query_chunks(std::filesystem::path const& query_file, size_t limit, size_t chunk_size,
+                              bounded_queue<query_chunk>& queue, size_t threads = default_inflate_threads()) {
+    query_chunk chunk{0, 0, {}, {}};
+    size_t produced = 0;
+    while (produced < limit) {
+        size_t read = 0;
+        auto query_stream = sequence_input{query_file, threads};
+        for (auto& record : query_stream) {
+            if (produced == limit) break;
+            chunk.queries.push_back(record.sequence());
+            chunk.ids.push_back(record.id());
+            ++produced;
+            ++read;
+            if (chunk.queries.size() == chunk_size) {
+                size_t next_index = chunk.index + 1;
+                if (!queue.push(std::move(chunk))) return;
+                chunk = query_chunk{next_index, produced, {}, {}};
+            }
+        }
+        if (read == 0) break; // an empty query file can not be repeated
+    }
+    if (!chunk.queries.empty()) {
+        queue.push(std::move(chunk));
+    }
+}
+
+// splits fasta or fastq records held in memory into chunks of chunk_size queries, fastq is recognized by its leading '@'
+inline std::vector<query_chunk> parse_query_chunks(std::string const& records, size_t chunk_size = query_chunk_size) {
+    std::vector<query_chunk> chunks;
+    size_t first = records.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) return chunks;
+    std::istringstream stream{records};
+    stream.exceptions(std::ios::badbit);
+    auto parse = [&](auto&& file) {
+        size_t count = 0;
+        for (auto& record : file) {
+            if (count % chunk_size == 0) {
+                chunks.push_back(query_chunk{chunks.size(), count, {}, {}});
+            }
+            chunks.back().queries.push_back(record.sequence());
+            chunks.back().ids.push_back(record.id());
+            ++count;
+        }
+    };
+    if (records[first] == '@') {
+        parse(seqan3::sequence_file_input<>{stream, seqan3::format_fastq{}});
+    } else {
+        parse(seqan3::sequence_file_input<>{stream, seqan3::format_fasta{}});
+    }
+    return chunks;
+}
+
+// chunks a search works on at the same time per thread: taken by a worker and not written yet
+inline constexpr size_t query_window_per_thread = 4;
+
+// searches the first limit queries of query_file with `threads` workers, each chunk is handled by
+// search_chunk(thread_id, chunk, chunk_output), which leaves the chunk's output in chunk_output; the output is
+// written in chunk order and its buffer handed back as chunk_output of a later chunk, cleared but with its capacity
+// at most query_window_per_thread * threads chunks are in flight, so a slow chunk stalls the workers instead of
+// letting the output held back behind it grow
+// exceptions of any stage stop the pipeline and are rethrown on the calling thread
+template <typename search_fn_t>
+void stream_queries(std::filesystem::path const& query_file, size_t limit, size_t threads,
+                    search_fn_t&& search_chunk, std::ostream* output = nullptr) {
+    threads = std::max<size_t>(1, threads);
+    size_t const window = query_window_per_thread * threads;
+    bounded_queue<query_chunk> chunks{2 * threads};
+    bounded_queue<std::pair<size_t, std::string>> results{2 * threads};
+
+    // a worker takes a slot before it pops a chunk, the slot is freed once the chunk is written; buffers of
+    // written chunks are kept for the output of later chunks
+    std::mutex window_mutex;
+    std::condition_variable slot_freed;
+    size_t in_flight = 0;
+    bool stopped = false;
+    std::vector<std::string> spare;
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto fail = [&]() {
+        {
+            std::lock_guard lock{error_mutex};
+            if (!error) error = std::current_exception();
+        }
+        {
+            std::lock_guard lock{window_mutex};
+            stopped = true;
+        }
+        slot_freed.notify_all();
+        chunks.cancel();
+        results.cancel();
+    };
+
+    std::thread reader{[&]() {
+        try {
+            // the search threads are busy with the chunks, so the reader inflates with no more than there are
+            read_query_chunks(query_file, limit, query_chunk_size, chunks, std::min(threads, default_inflate_threads()));
+        } catch (...) {
+            fail();
+        }
+        chunks.close();
+    }};
+
+    std::atomic<size_t> running{threads};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            try {
+                while (true) {
+                    std::string chunk_output;
+                    {
+                        std::unique_lock lock{window_mutex};
+                        slot_freed.wait(lock, [&] { return stopped || in_flight < window; });
+                        if (stopped) break;
+                        ++in_flight;
+                        if (!spare.empty()) {
+                            chunk_output.swap(spare.back());
+                            spare.pop_back();
+                        }
+                    }
+                    auto chunk = chunks.pop();
+                    if (!chunk) {
+                        std::lock_guard lock{window_mutex};
+                        --in_flight;
+                        break;
+                    }
+                    search_chunk(t, *chunk, chunk_output);
+                    if (!results.push({chunk->index, std::move(chunk_output)})) break;
+                }
+            } catch (...) {
+                fail();
+            }
+            if (--running == 0) results.close();
+        });
+    }
+
+    // chunks finish out of order, so their output waits until all chunks before them are written; the chunks in
+    // flight are [next, next + window), so their output has a slot of its own in `pending`
+    std::vector<std::string> pending(window);
+    std::vector<char> ready(window, 0);
+    size_t next = 0;
+    while (auto result = results.pop()) {
+        auto& [index, chunk_output] = *result;
+        size_t written = 1;
+        if (output != nullptr) {
+            pending[index % window].swap(chunk_output);
+            ready[index % window] = 1;
+            for (written = 0; ready[next % window]; ++next, ++written) {
+                auto& buffer = pending[next % window];
+                *output << buffer;
+                buffer.clear();
+                ready[next % window] = 0;
+                std::lock_guard lock{window_mutex};
+                spare.push_back(std::move(buffer));
+            }
+        }
+        {
+            std::lock_guard lock{window_mutex};
+            in_flight -= written;
+        }
+        slot_freed.notify_all();
+    }
+
+    reader.join();
+    for (auto& w : workers) {
+        w.join();
+    }
+    if (error) std::rethrow_exception(error);
+}
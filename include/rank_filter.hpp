@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Candidate filter of the exact search over a window of dna5 ranks, one byte per base.
+// Position i is a candidate if text[i] == first and text[i + last_offset] == last. The vector kernels compare
+// 16, 32 or 64 positions at once and turn both compares into one bit mask of candidates, like a two byte memchr.
+// text must be readable up to positions + last_offset, candidates must have room for positions entries.
+
+// positions [from, positions) one at a time, appended behind count candidates
+inline size_t rank_filter_tail(uint8_t const* text, size_t from, size_t positions, size_t last_offset,
+                               uint8_t first, uint8_t last, uint32_t* candidates, size_t count) {
+    for (size_t i = from; i < positions; ++i) {
+        if (text[i] == first && text[i + last_offset] == last) candidates[count++] = i;
+    }
+    return count;
+}
+
+inline size_t rank_filter_scalar(uint8_t const* text, size_t positions, size_t last_offset,
+                                 uint8_t first, uint8_t last, uint32_t* candidates) {
+    return rank_filter_tail(text, 0, positions, last_offset, first, last, candidates, 0);
+}
+
+// appends the positions of the set bits of mask, offset by base
+inline size_t rank_filter_emit(uint64_t mask, size_t base, uint32_t* candidates, size_t count) {
+    for (; mask != 0; mask &= mask - 1) {
+        candidates[count++] = base + __builtin_ctzll(mask);
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// sse2 is part of x86-64, but not of 32 bit x86, so like the wider kernels it is compiled for its target and selected
+// only if the cpu has it
+__attribute__((target("sse2")))
+inline size_t rank_filter_sse2(uint8_t const* text, size_t positions, size_t last_offset,
+                               uint8_t first, uint8_t last, uint32_t* candidates) {
+    __m128i const f = _mm_set1_epi8(static_cast<char>(first));
+    __m128i const l = _mm_set1_epi8(static_cast<char>(last));
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= positions; i += 16) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(text + i)), f);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(text + i + last_offset)), l);
+        count = rank_filter_emit(static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(a, b))), i, candidates, count);
+    }
+    return rank_filter_tail(text, i, positions, last_offset, first, last, candidates, count);
+}
+
+__attribute__((target("avx2")))
+inline size_t rank_filter_avx2(uint8_t const* text, size_t positions, size_t last_offset,
+                               uint8_t first, uint8_t last, uint32_t* candidates) {
+    __m256i const f = _mm256_set1_epi8(static_cast<char>(first));
+    __m256i const l = _mm256_set1_epi8(static_cast<char>(last));
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= positions; i += 32) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + i)), f);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + i + last_offset)), l);
+        count = rank_filter_emit(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(a, b))), i, candidates, count);
+    }
+    return rank_filter_tail(text, i, positions, last_offset, first, last, candidates, count);
+}
+
+// 64 positions per step, compares go straight into mask registers
+__attribute__((target("avx512f,avx512bw")))
+inline size_t rank_filter_avx512(uint8_t const* text, size_t positions, size_t last_offset,
+                                 uint8_t first, uint8_t last, uint32_t* candidates) {
+    __m512i const f = _mm512_set1_epi8(static_cast<char>(first));
+    __m512i const l = _mm512_set1_epi8(static_cast<char>(last));
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 64 <= positions; i += 64) {
+        __mmask64 a = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(text + i), f);
+        __mmask64 b = _mm512_mask_cmpeq_epi8_mask(a, _mm512_loadu_si512(text + i + last_offset), l);
+        count = rank_filter_emit(b, i, candidates, count);
+    }
+    return rank_filter_tail(text, i, positions, last_offset, first, last, candidates, count);
+}
+#endif
+
+using rank_filter_fn = size_t (*)(uint8_t const*, size_t, size_t, uint8_t, uint8_t, uint32_t*);
+
+// widest kernel the running cpu supports
+inline rank_filter_fn select_rank_filter_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return rank_filter_avx512;
+    if (__builtin_cpu_supports("avx2")) return rank_filter_avx2;
+    if (__builtin_cpu_supports("sse2")) return rank_filter_sse2;
+#endif
+    return rank_filter_scalar;
+}
+
+inline rank_filter_fn const rank_filter_kernel = select_rank_filter_kernel();
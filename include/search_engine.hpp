@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <seqan3/argument_parser/all.hpp>
+
+#include "hit_writer.hpp"
+#include "query_stream.hpp"
+
+// The search library behind the command line tools.
+// A search_engine holds a loaded index or reference and is shared read-only by all threads, every thread
+// searches query chunks with a search_worker of its own that owns its scratch buffers.
+// run_search drives an engine over a query file: it streams the queries, writes the hits and times the search.
+
+// options of all tools, every engine reads the ones it needs
+struct search_options {
+    std::filesystem::path reference_file;
+    std::filesystem::path index_path;
+    std::filesystem::path query_file;
+    unsigned long int query_limit = 100;
+    unsigned char errors = 0;
+    unsigned char bi_fm_index = 0;
+    std::string search_scheme;
+    unsigned char indels = 0;
+    unsigned char batched_seeding = 0;
+    unsigned char multi_pattern = 0;
+    unsigned int scan_threads = 1;
+    std::string strand = "forward";
+    unsigned int threads = 1;
+    std::filesystem::path output_file;
+    std::string output_format = "tsv";
+    unsigned char dedup = 0;
+    unsigned long int query_cache = 0;
+};
+
+class search_worker {
+public:
+    virtual ~search_worker() = default;
+
+    // searches every query of chunk, adds the hits to `hits` unless it is null and returns their number;
+    // unless query_counts is empty, the number of hits of every query q is added to query_counts[q]
+    virtual uint64_t search(query_chunk const& chunk, hit_sink* hits, std::span<uint64_t> query_counts) = 0;
+
+    uint64_t search(query_chunk const& chunk, hit_sink* hits) { return search(chunk, hits, {}); }
+};
+
+class search_engine {
+public:
+    virtual ~search_engine() = default;
+
+    // name of the method in the report
+    virtual std::string method() const = 0;
+
+    // lengths of the reference sequences for the sam header, empty if the index does not know them
+    virtual std::vector<uint64_t> sequence_lengths() const { return {}; }
+
+    virtual std::unique_ptr<search_worker> make_worker() const = 0;
+};
+
+// engines of the search tools, they load their index or reference on construction
+std::unique_ptr<search_engine> make_naive_engine(search_options const& options);
+std::unique_ptr<search_engine> make_suffix_array_engine(search_options const& options);
+std::unique_ptr<search_engine> make_fm_index_engine(search_options const& options);
+std::unique_ptr<search_engine> make_pigeon_engine(search_options const& options);
+
+// engine by name: naive, suffixarray, fmindex or pigeon
+std::unique_ptr<search_engine> make_search_engine(std::string const& name, search_options const& options);
+
+// wraps worker so that identical queries are searched once per chunk, and the results of the last
+// cache_capacity distinct queries are reused by later chunks
+std::unique_ptr<search_worker> make_dedup_worker(std::unique_ptr<search_worker> worker, size_t cache_capacity);
+
+// a worker of engine, deduplicating and caching queries if options.dedup or options.query_cache ask for it
+std::unique_ptr<search_worker> make_search_worker(search_engine const& engine, search_options const& options);
+
+struct search_report {
+    std::string method;
+    uint64_t total_count = 0;
+    std::chrono::nanoseconds duration{0};
+    uint64_t allocations = 0; // heap allocations inside of the workers' search calls
+};
+
+// searches the queries of options.query_file on options.threads threads
+search_report run_search(search_engine const& engine, search_options const& options);
+
+// the ">>>>>" block the experiment scripts parse
+void print_report(std::ostream& os, search_options const& options, search_report const& report);
+
+// sets up the parser of a tool the way all tools share
+void init_parser(seqan3::argument_parser& parser);
+
+// options every search tool takes: query, query-lim, strand, threads, output, output-format, dedup and query-cache
+void add_query_options(seqan3::argument_parser& parser, search_options& options);
+
+// parses the command line, prints the error and returns false if that fails
+bool parse_arguments(seqan3::argument_parser& parser);
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Framing between search_server and search_client, the same over a unix domain socket and over stdin/stdout:
+//
+//   request:  "SEARCH <index> <tsv|sam|count> <bytes>\n" followed by <bytes> bytes of fasta or fastq
+//   response: "OK <hits> <bytes>\n" followed by <bytes> bytes of hits in the requested format (none for count)
+//             "ERROR <message>\n" if the request could not be served or its line not parsed, the connection stays
+//             usable; if the stream ends or fails inside of a request, the error is sent and the connection ends
+//   "QUIT\n" or the end of the stream ends a connection.
+//
+// <bytes> is a decimal number without a sign. A request of more than protocol_max_request_bytes is skipped and
+// answered with an error.
+
+inline constexpr size_t protocol_max_line = 4096;
+inline constexpr uint64_t protocol_max_request_bytes = uint64_t{1} << 30;
+
+// a request line that can not be parsed; the stream is left at the start of the next line, so the connection stays
+// usable. Every other exception of the stream means it failed or lost its framing.
+struct protocol_error : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// buffered reads and complete writes on a file descriptor
+class fd_stream {
+    int in_;
+    int out_;
+    char buffer_[1 << 16];
+    size_t begin_ = 0;
+    size_t end_ = 0;
+
+    bool fill() {
+        while (true) {
+            ssize_t got = ::read(in_, buffer_, sizeof(buffer_));
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) throw std::runtime_error(std::string{"read failed: "} + std::strerror(errno));
+            begin_ = 0;
+            end_ = got;
+            return got > 0;
+        }
+    }
+
+public:
+    fd_stream(int in, int out) : in_{in}, out_{out} {}
+
+    // reads a line without its newline, false at the end of the stream
+    bool read_line(std::string& line) {
+        line.clear();
+        while (true) {
+            if (begin_ == end_ && !fill()) {
+                if (line.empty()) return false;
+                throw std::runtime_error("stream ended inside of a line");
+            }
+            auto newline = static_cast<char const*>(std::memchr(buffer_ + begin_, '\n', end_ - begin_));
+            size_t stop = newline ? newline - buffer_ : end_;
+            line.append(buffer_ + begin_, stop - begin_);
+            begin_ = newline ? stop + 1 : stop;
+            if (line.size() > protocol_max_line) {
+                if (!newline) skip_line();
+                throw protocol_error("line too long");
+            }
+            if (newline) return true;
+        }
+    }
+
+    // drops the rest of the current line with its newline
+    void skip_line() {
+        while (begin_ != end_ || fill()) {
+            auto newline = static_cast<char const*>(std::memchr(buffer_ + begin_, '\n', end_ - begin_));
+            if (newline) {
+                begin_ = newline - buffer_ + 1;
+                return;
+            }
+            begin_ = end_;
+        }
+    }
+
+    // drops the next n bytes
+    void skip_exact(uint64_t n) {
+        while (n > 0) {
+            if (begin_ == end_ && !fill()) throw std::runtime_error("stream ended inside of a message");
+            size_t take = std::min<uint64_t>(n, end_ - begin_);
+            begin_ += take;
+            n -= take;
+        }
+    }
+
+    // reads exactly n bytes
+    void read_exact(std::string& data, size_t n) {
+        data.resize(n);
+        size_t done = 0;
+        while (done < n) {
+            if (begin_ == end_ && !fill()) throw std::runtime_error("stream ended inside of a message");
+            size_t take = std::min(n - done, end_ - begin_);
+            std::memcpy(data.data() + done, buffer_ + begin_, take);
+            begin_ += take;
+            done += take;
+        }
+    }
+
+    void write_all(std::string_view data) {
+        while (!data.empty()) {
+            ssize_t put = ::write(out_, data.data(), data.size());
+            if (put < 0 && errno == EINTR) continue;
+            if (put < 0) throw std::runtime_error(std::string{"write failed: "} + std::strerror(errno));
+            data.remove_prefix(put);
+        }
+    }
+};
+
+struct search_request {
+    std::string index;
+    std::string format;  // tsv, sam or count
+    std::string queries; // fasta or fastq records
+};
+
+struct search_response {
+    bool ok = false;
+    uint64_t hits = 0;
+    std::string body;    // the hits if ok, the error message otherwise
+};
+
+// false once the client quits or closes the stream
+inline bool read_request(fd_stream& stream, search_request& request) {
+    std::string line;
+    if (!stream.read_line(line) || line == "QUIT") return false;
+    std::istringstream words{line};
+    std::string command, size;
+    if (!(words >> command >> request.index >> request.format >> size) || command != "SEARCH") {
+        throw protocol_error("malformed request: " + line);
+    }
+    // from_chars takes no sign for an unsigned value and reports an overflow instead of wrapping
+    uint64_t bytes = 0;
+    auto [end, error] = std::from_chars(size.data(), size.data() + size.size(), bytes);
+    if (error != std::errc{} || end != size.data() + size.size()) {
+        throw protocol_error("malformed request size: " + line);
+    }
+    if (bytes > protocol_max_request_bytes) {
+        // the queries are skipped without being held, so the next request is framed again
+        stream.skip_exact(bytes);
+        throw protocol_error("request of " + size + " bytes exceeds the limit of "
+                             + std::to_string(protocol_max_request_bytes) + " bytes");
+    }
+    stream.read_exact(request.queries, bytes);
+    return true;
+}
+
+inline void write_request(fd_stream& stream, search_request const& request) {
+    stream.write_all("SEARCH " + request.index + ' ' + request.format + ' ' + std::to_string(request.queries.size()) + '\n');
+    stream.write_all(request.queries);
+}
+
+inline search_response read_response(fd_stream& stream) {
+    std::string line;
+    if (!stream.read_line(line)) throw std::runtime_error("the server closed the connection");
+    search_response response;
+    if (line.rfind("ERROR ", 0) == 0) {
+        response.body = line.substr(6);
+        return response;
+    }
+    std::istringstream words{line};
+    std::string status;
+    size_t bytes = 0;
+    if (!(words >> status >> response.hits >> bytes) || status != "OK") {
+        throw std::runtime_error("malformed response: " + line);
+    }
+    stream.read_exact(response.body, bytes);
+    response.ok = true;
+    return response;
+}
+
+inline void write_response(fd_stream& stream, search_response const& response) {
+    if (!response.ok) {
+        std::string message = response.body;
+        for (auto& c : message) {
+            if (c == '\n') c = ' ';
+        }
+        stream.write_all("ERROR " + message + '\n');
+        return;
+    }
+    stream.write_all("OK " + std::to_string(response.hits) + ' ' + std::to_string(response.body.size()) + '\n');
+    stream.write_all(response.body);
+}
+
+inline sockaddr_un unix_socket_address(std::filesystem::path const& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.string().size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("socket path " + path.string() + " is too long");
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+// listening socket at path, a stale socket file from an earlier server is replaced
+inline int listen_unix_socket(std::filesystem::path const& path) {
+    auto address = unix_socket_address(path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error(std::string{"socket failed: "} + std::strerror(errno));
+    std::filesystem::remove(path);
+    if (::bind(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 || ::listen(fd, 64) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error("could not listen on " + path.string() + ": " + std::strerror(error));
+    }
+    return fd;
+}
+
+inline int connect_unix_socket(std::filesystem::path const& path) {
+    auto address = unix_socket_address(path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error(std::string{"socket failed: "} + std::strerror(errno));
+    if (::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error("could not connect to " + path.string() + ": " + std::strerror(error));
+    }
+    return fd;
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+// A search scheme (Kucherov et al. 2016) splits the query into pieces and runs several searches on a
+// bidirectional index. Every search matches the pieces in the order pi and after matching pi[0..j]
+// the number of substitutions must lie in [l[j], u[j]]. The scheme is complete for k errors if every
+// distribution of at most k errors over the pieces is admitted by at least one search.
+// Pieces are numbered from 0, pi must extend the already matched part of the query to the left or right.
+struct scheme_search {
+    std::vector<uint8_t> pi;
+    std::vector<uint8_t> l;
+    std::vector<uint8_t> u;
+};
+
+using search_scheme = std::vector<scheme_search>;
+
+// most errors a named scheme is made for; pieces and bounds are stored in uint8_t, and check_search_scheme
+// enumerates every distribution of the errors over the pieces, which grows exponentially with them
+inline constexpr size_t max_search_scheme_errors = 8;
+
+// The optimum search schemes of Kianfar et al. 2018 for up to 4 errors, the table for 4 errors as given there.
+// They minimize the expected number of visited index nodes and admit every distribution of errors over the pieces
+// exactly once, so no occurrence is reported twice.
+inline search_scheme optimum_search_scheme(size_t k) {
+    switch (k) {
+    case 0: return {{{0}, {0}, {0}}};
+    case 1: return {{{0, 1}, {0, 0}, {0, 1}},
+                    {{1, 0}, {0, 1}, {0, 1}}};
+    case 2: return {{{0, 1, 2, 3}, {0, 0, 1, 1}, {0, 0, 2, 2}},
+                    {{2, 1, 0, 3}, {0, 0, 0, 0}, {0, 1, 1, 2}},
+                    {{3, 2, 1, 0}, {0, 0, 0, 2}, {0, 1, 2, 2}}};
+    case 3: return {{{0, 1, 2, 3, 4}, {0, 0, 0, 0, 3}, {0, 2, 2, 3, 3}},
+                    {{1, 2, 3, 4, 0}, {0, 0, 0, 2, 2}, {0, 1, 2, 2, 3}},
+                    {{2, 3, 4, 1, 0}, {0, 0, 1, 1, 1}, {0, 1, 1, 2, 3}},
+                    {{4, 3, 2, 1, 0}, {0, 0, 0, 0, 0}, {0, 0, 3, 3, 3}}};
+    case 4: return {{{0, 1, 2, 3, 4, 5}, {0, 0, 0, 0, 0, 4}, {0, 3, 3, 3, 4, 4}},
+                    {{1, 2, 3, 4, 5, 0}, {0, 0, 0, 0, 3, 3}, {0, 2, 2, 3, 3, 4}},
+                    {{2, 3, 4, 5, 1, 0}, {0, 0, 0, 2, 2, 2}, {0, 1, 2, 2, 3, 4}},
+                    {{3, 4, 5, 2, 1, 0}, {0, 0, 1, 1, 1, 1}, {0, 1, 1, 2, 3, 4}},
+                    {{5, 4, 3, 2, 1, 0}, {0, 0, 0, 0, 0, 0}, {0, 0, 4, 4, 4, 4}}};
+    }
+    throw std::invalid_argument("optimum search schemes are available for up to 4 errors");
+}
+
+// Pigeonhole schemes: k + 1 pieces and one search per piece, starting with that piece error free. They are
+// hand-made and serve as a baseline for the optimum schemes. Every scheme is complete for k errors
+// (check_search_scheme). Searches admit some error distributions twice, 1 of 10 for k = 2, 8 of 35 for k = 3
+// and 46 of 126 for k = 4, so locate_with_scheme removes duplicate hits.
+inline search_scheme pigeon_search_scheme(size_t k) {
+    switch (k) {
+    case 0: return {{{0}, {0}, {0}}};
+    case 1: return {{{0, 1}, {0, 1}, {0, 1}},
+                    {{1, 0}, {0, 0}, {0, 1}}};
+    case 2: return {{{0, 1, 2}, {0, 1, 2}, {0, 1, 2}},
+                    {{1, 0, 2}, {0, 0, 1}, {0, 1, 2}},
+                    {{2, 1, 0}, {0, 0, 0}, {0, 2, 2}}};
+    case 3: return {{{0, 1, 2, 3}, {0, 1, 2, 3}, {0, 1, 3, 3}},
+                    {{1, 0, 2, 3}, {0, 0, 1, 2}, {0, 1, 3, 3}},
+                    {{2, 1, 0, 3}, {0, 0, 0, 1}, {0, 2, 2, 3}},
+                    {{3, 2, 1, 0}, {0, 0, 0, 0}, {0, 1, 3, 3}}};
+    case 4: return {{{0, 1, 2, 3, 4}, {0, 1, 2, 3, 4}, {0, 1, 3, 4, 4}},
+                    {{1, 0, 2, 3, 4}, {0, 0, 1, 2, 3}, {0, 1, 3, 4, 4}},
+                    {{2, 1, 0, 3, 4}, {0, 0, 0, 1, 2}, {0, 2, 2, 4, 4}},
+                    {{3, 2, 1, 0, 4}, {0, 0, 0, 0, 1}, {0, 1, 3, 3, 4}},
+                    {{4, 3, 2, 1, 0}, {0, 0, 0, 0, 0}, {0, 1, 4, 4, 4}}};
+    }
+    throw std::invalid_argument("pigeon search schemes are available for up to 4 errors");
+}
+
+// the schemes Kucherov, Salikhov and Tsur give for 1 and 2 errors, use the optimum schemes for more errors
+inline search_scheme kucherov_search_scheme(size_t k) {
+    switch (k) {
+    case 0: return {{{0}, {0}, {0}}};
+    case 1: return {{{0, 1}, {0, 0}, {0, 1}},
+                    {{1, 0}, {0, 1}, {0, 1}}};
+    case 2: return {{{0, 1, 2}, {0, 0, 0}, {0, 2, 2}},
+                    {{2, 1, 0}, {0, 0, 0}, {0, 1, 2}},
+                    {{1, 2, 0}, {0, 1, 1}, {0, 1, 2}}};
+    }
+    throw std::invalid_argument("Kucherov search schemes are available for up to 2 errors, "
+                                "the optimum search schemes for up to 4");
+}
+
+// 01*0 seeds (Vroland et al. 2016): with k + 2 pieces every occurrence contains two error free pieces
+// with exactly one error in each piece between them. There is one search per first error free piece i
+// and number m of pieces between the two.
+inline search_scheme seeds_01_0_search_scheme(size_t k) {
+    if (k > max_search_scheme_errors) {
+        throw std::invalid_argument("01*0 search schemes are available for up to "
+                                    + std::to_string(max_search_scheme_errors) + " errors");
+    }
+    size_t const p = k + 2;
+    search_scheme scheme;
+    for (size_t i = 0; i + 1 < p; ++i) {
+        for (size_t m = 0; i + m + 1 < p; ++m) {
+            scheme_search s;
+            for (size_t j = i; j < p; ++j) s.pi.push_back(static_cast<uint8_t>(j));
+            for (size_t j = i; j > 0; --j) s.pi.push_back(static_cast<uint8_t>(j - 1));
+            s.l.push_back(0);
+            for (size_t j = 1; j <= m; ++j) s.l.push_back(static_cast<uint8_t>(j));
+            s.l.push_back(static_cast<uint8_t>(m));
+            s.u = s.l;
+            while (s.l.size() < p) {
+                s.l.push_back(static_cast<uint8_t>(m));
+                s.u.push_back(static_cast<uint8_t>(k));
+            }
+            scheme.push_back(std::move(s));
+        }
+    }
+    return scheme;
+}
+
+// parses the notation of the literature, e.g. "12/00/01;21/01/01": one search per ';', with piece order,
+// lower and upper bounds separated by '/' and pieces numbered from 1
+inline search_scheme parse_search_scheme(std::string const& text) {
+    search_scheme scheme;
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = std::min(text.find(';', begin), text.size());
+        std::string s = text.substr(begin, end - begin);
+        size_t slash1 = s.find('/');
+        size_t slash2 = slash1 == std::string::npos ? std::string::npos : s.find('/', slash1 + 1);
+        if (slash2 == std::string::npos) {
+            throw std::invalid_argument("search '" + s + "' is not of the form order/lower/upper");
+        }
+        auto digits = [&s](std::string const& field, int offset) {
+            std::vector<uint8_t> values;
+            for (char c : field) {
+                if (c < '0' || c > '9' || c - '0' - offset < 0) {
+                    throw std::invalid_argument("invalid character in search '" + s + "'");
+                }
+                values.push_back(c - '0' - offset);
+            }
+            return values;
+        };
+        scheme.push_back({digits(s.substr(0, slash1), 1),
+                          digits(s.substr(slash1 + 1, slash2 - slash1 - 1), 0),
+                          digits(s.substr(slash2 + 1), 0)});
+        begin = end + 1;
+    }
+    return scheme;
+}
+
+// named scheme ("optimum", "pigeon", "kucherov", "01*0") or a scheme in the notation of parse_search_scheme,
+// for at most max_search_scheme_errors errors
+inline search_scheme make_search_scheme(std::string const& name, size_t k) {
+    if (k > max_search_scheme_errors) {
+        throw std::invalid_argument("search schemes are available for up to " + std::to_string(max_search_scheme_errors)
+                                    + " errors, not " + std::to_string(k));
+    }
+    if (name == "optimum") return optimum_search_scheme(k);
+    if (name == "pigeon") return pigeon_search_scheme(k);
+    if (name == "kucherov") return kucherov_search_scheme(k);
+    if (name == "01*0") return seeds_01_0_search_scheme(k);
+    return parse_search_scheme(name);
+}
+
+// throws std::invalid_argument, if the searches are malformed or do not find every occurrence with up to k errors
+inline void check_search_scheme(search_scheme const& scheme, size_t k) {
+    if (scheme.empty()) {
+        throw std::invalid_argument("search scheme has no searches");
+    }
+    size_t p = scheme.front().pi.size();
+    for (auto const& s : scheme) {
+        if (s.pi.size() != p || s.l.size() != p || s.u.size() != p || p == 0) {
+            throw std::invalid_argument("all searches of a scheme need the same number of pieces and bounds");
+        }
+        size_t lo = s.pi[0], hi = s.pi[0];
+        for (size_t j = 0; j < p; ++j) {
+            if (j > 0) {
+                if (s.pi[j] == hi + 1) {
+                    hi++;
+                } else if (s.pi[j] + size_t{1} == lo) {
+                    lo--;
+                } else {
+                    throw std::invalid_argument("piece order of a search must extend the matched part to the left or right");
+                }
+            }
+            if (s.pi[j] >= p || s.l[j] > s.u[j] || s.u[j] > k || (j > 0 && (s.l[j] < s.l[j - 1] || s.u[j] < s.u[j - 1]))) {
+                throw std::invalid_argument("bounds of a search must be non-decreasing with lower <= upper <= errors");
+            }
+        }
+    }
+    // enumerate all distributions of at most k errors over the pieces
+    std::vector<uint8_t> errors(p, 0);
+    std::function<void(size_t, size_t)> cover = [&](size_t piece, size_t left) {
+        if (piece < p) {
+            for (size_t e = 0; e <= left; ++e) {
+                errors[piece] = e;
+                cover(piece + 1, left - e);
+            }
+            return;
+        }
+        bool admitted = std::any_of(scheme.begin(), scheme.end(), [&](scheme_search const& s) {
+            size_t sum = 0;
+            for (size_t j = 0; j < p; ++j) {
+                sum += errors[s.pi[j]];
+                if (sum < s.l[j] || sum > s.u[j]) return false;
+            }
+            return true;
+        });
+        if (!admitted) {
+            throw std::invalid_argument("search scheme misses occurrences with " + std::to_string(k - left) + " errors");
+        }
+    };
+    cover(0, k);
+}
+
+// one character of a search: the query position, the direction and the bounds of the piece it belongs to
+struct search_scheme_step {
+    size_t position;
+    bool right;
+    uint8_t lower;
+    uint8_t upper;
+    size_t piece_remaining; // characters of the same piece after this one
+};
+
+// the characters of search s in the order they are matched, for a query of length m
+inline std::vector<search_scheme_step> plan_search(scheme_search const& s, size_t m) {
+    size_t p = s.pi.size();
+    if (m < p) {
+        throw std::invalid_argument("query is shorter than the number of pieces of the search scheme");
+    }
+    auto piece_begin = [m, p](size_t piece) { return piece * (m / p) + std::min(piece, m % p); };
+    std::vector<search_scheme_step> plan;
+    for (size_t j = 0; j < p; ++j) {
+        size_t begin = piece_begin(s.pi[j]), end = piece_begin(s.pi[j] + 1);
+        bool right = j == 0 || s.pi[j] > s.pi[0];
+        for (size_t i = 0; i < end - begin; ++i) {
+            size_t position = right ? begin + i : end - 1 - i;
+            plan.push_back({position, right, s.l[j], s.u[j], end - begin - 1 - i});
+        }
+    }
+    return plan;
+}
+
+template <typename cursor_t, typename query_t, typename callback_t>
+void search_scheme_extend(cursor_t const& cursor, query_t const& query, std::vector<search_scheme_step> const& plan,
+                          size_t i, size_t errors, callback_t& on_hit) {
+    if (i == plan.size()) {
+        on_hit(cursor, errors);
+        return;
+    }
+    auto const& step = plan[i];
+    auto expected = seqan3::to_rank(query[step.position]);
+    for (uint8_t r = 0; r < seqan3::alphabet_size<seqan3::dna5>; ++r) {
+        size_t e = errors + (r != expected);
+        // the piece can still reach its lower bound only if the remaining characters are enough
+        if (e > step.upper || e + step.piece_remaining < step.lower) continue;
+        auto next = cursor;
+        auto c = seqan3::assign_rank_to(r, seqan3::dna5{});
+        if (step.right ? next.extend_right(c) : next.extend_left(c)) {
+            search_scheme_extend(next, query, plan, i + 1, e, on_hit);
+        }
+    }
+}
+
+// calls on_hit(cursor, errors) for every match of query found by the searches of the scheme on a
+// bidirectional index, the same occurrence can be reported by several searches
+template <typename index_t, typename query_t, typename callback_t>
+void search_with_scheme(index_t const& index, query_t const& query, search_scheme const& scheme, callback_t&& on_hit) {
+    for (auto const& s : scheme) {
+        auto plan = plan_search(s, query.size());
+        search_scheme_extend(index.cursor(), query, plan, 0, 0, on_hit);
+    }
+}
+
+// all distinct (reference id, position, errors) occurrences of query found by the scheme, an occurrence
+// reported by several searches keeps its lowest number of errors
+template <typename index_t, typename query_t>
+std::vector<std::tuple<size_t, size_t, size_t>> locate_with_scheme(index_t const& index, query_t const& query, search_scheme const& scheme) {
+    std::vector<std::tuple<size_t, size_t, size_t>> hits;
+    search_with_scheme(index, query, scheme, [&hits](auto const& cursor, size_t errors) {
+        for (auto const& [reference_id, position] : cursor.locate()) {
+            hits.emplace_back(reference_id, position, errors);
+        }
+    });
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end(), [](auto const& a, auto const& b) {
+        return std::get<0>(a) == std::get<0>(b) && std::get<1>(a) == std::get<1>(b);
+    }), hits.end());
+    return hits;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+// Strands a query is searched on. A hit on the reverse strand is an occurrence of the reverse complement
+// of the query, its position is the first forward strand position of the occurrence, as in sam.
+
+enum class strand_mode { forward, reverse, both };
+
+// complement of every dna5 rank (A C G N T)
+inline constexpr std::array<uint8_t, 5> dna5_rank_complement{4, 2, 1, 3, 0};
+
+inline strand_mode parse_strand_mode(std::string const& name) {
+    if (name == "forward") return strand_mode::forward;
+    if (name == "reverse") return strand_mode::reverse;
+    if (name == "both") return strand_mode::both;
+    throw std::runtime_error("unknown strand " + name + ", expected forward, reverse or both");
+}
+
+// the strands searched in mode, '+' before '-'
+inline std::string_view strands(strand_mode mode) {
+    switch (mode) {
+        case strand_mode::forward: return "+";
+        case strand_mode::reverse: return "-";
+        default: return "+-";
+    }
+}
+
+// writes the reverse complement of query to out, reusing its buffer
+template <typename query_t>
+void reverse_complement(query_t const& query, std::vector<seqan3::dna5>& out) {
+    size_t const m = query.size();
+    out.resize(m);
+    for (size_t j = 0; j < m; ++j) {
+        out[m - 1 - j] = seqan3::assign_rank_to(dna5_rank_complement[seqan3::to_rank(query[j])], seqan3::dna5{});
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "packed_reference.hpp"
+#include "suffix_sort.hpp"
+
+// On-disk layout of the suffix array index, every section starts at a multiple of 64 bytes:
+//
+//   [sa_header][packed words][n runs][uint64_t sequence_starts[sequence_count + 1]][saidx_t suffix array]
+//
+// The suffix array is over the concatenation of all reference sequences, sorted by dna5 rank as if every sequence
+// were terminated by a separator smaller than all bases. Its entries are saidx_t, or saidx64_t for texts of
+// 2^31 characters and more.
+inline constexpr char sa_magic[8] = {'I', 'S', 'S', 'A', 'I', 'D', 'X', '\0'};
+inline constexpr uint32_t sa_version = 3;
+
+struct alignas(64) sa_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t text_length;
+    uint64_t sa_width;         // bytes per suffix array entry
+    uint64_t sequence_count;
+    uint64_t words_offset;
+    uint64_t runs_offset;
+    uint64_t run_count;
+    uint64_t sequence_starts_offset;
+    uint64_t sa_offset;
+};
+
+static_assert(sizeof(sa_header) % 64 == 0);
+
+// texts whose suffix sorting needs the 64-bit suffix array, the sorted text has a separator behind every sequence
+inline bool needs_64bit_suffix_array(packed_reference_view const& reference, sequence_boundaries boundaries) {
+    return needs_64bit_suffix_array(reference.size() + boundaries.count);
+}
+
+// suffix array over the dna5 ranks of `reference`, as used by suffixarray_search
+// the suffixes are sorted with a separator 0 behind every sequence and bases as rank + 1, like the text of a flat
+// fm-index, so the suffixes starting with a query form one interval without matches that cross a sequence border;
+// only the suffix sorting needs the text with one byte per symbol, it is freed right after
+template <typename sa_value_t>
+std::vector<sa_value_t> build_suffix_array(packed_reference_view const& reference, sequence_boundaries boundaries) {
+    std::vector<sauchar_t> text(reference.size() + boundaries.count);
+    std::vector<uint64_t> separators; // position of the separator behind every sequence in text
+    uint64_t t = 0;
+    for (uint64_t id = 0; id < boundaries.count; ++id) {
+        uint64_t length = boundaries.end(id) - boundaries.start(id);
+        reference.ranks(boundaries.start(id), boundaries.end(id), text.data() + t);
+        for (uint64_t i = t; i < t + length; ++i) {
+            text[i]++;
+        }
+        t += length;
+        separators.push_back(t);
+        text[t++] = 0;
+    }
+    auto suffixarray = suffix_sort<sa_value_t>(text);
+    // the suffixes starting at separators are dropped, the others are shifted to their position in reference
+    uint64_t kept = 0;
+    for (auto sa : suffixarray) {
+        uint64_t pos = static_cast<uint64_t>(sa);
+        if (text[pos] == 0) continue;
+        uint64_t id = std::upper_bound(separators.begin(), separators.end(), pos) - separators.begin();
+        suffixarray[kept++] = static_cast<sa_value_t>(pos - id);
+    }
+    suffixarray.resize(kept);
+    return suffixarray;
+}
+
+template <typename sa_value_t>
+inline void save_suffix_array_index(std::filesystem::path const& path,
+                                    packed_reference_view const& reference,
+                                    std::vector<uint64_t> const& sequence_starts,
+                                    std::vector<sa_value_t> const& suffixarray) {
+    sa_header header{};
+    std::memcpy(header.magic, sa_magic, sizeof(sa_magic));
+    header.version = sa_version;
+    header.header_size = sizeof(sa_header);
+    header.text_length = reference.size();
+    header.sa_width = sizeof(sa_value_t);
+    header.sequence_count = sequence_starts.size() - 1;
+    header.words_offset = sizeof(sa_header);
+    uint64_t const word_count = (reference.size() + 31) / 32;
+    header.runs_offset = header.words_offset + padded_to_64(word_count * sizeof(uint64_t));
+    header.run_count = reference.run_count;
+    header.sequence_starts_offset = header.runs_offset + padded_to_64(header.run_count * sizeof(n_run));
+    header.sa_offset = header.sequence_starts_offset + padded_to_64(sequence_starts.size() * sizeof(uint64_t));
+
+    std::ofstream os{path, std::ios::binary};
+    if (!os) {
+        throw std::runtime_error("could not open " + path.string() + " for writing");
+    }
+    write_padded(os, &header, sizeof(header));
+    write_padded(os, reference.words, word_count * sizeof(uint64_t));
+    write_padded(os, reference.runs, header.run_count * sizeof(n_run));
+    write_padded(os, sequence_starts.data(), sequence_starts.size() * sizeof(uint64_t));
+    write_padded(os, suffixarray.data(), suffixarray.size() * sizeof(sa_value_t));
+    if (!os) {
+        throw std::runtime_error("failed writing " + path.string());
+    }
+}
+
+// mmap'ed suffix array index as written by save_suffix_array_index
+class suffix_array_index {
+    mapped_file file;
+    sa_header const* header = nullptr;
+
+public:
+    explicit suffix_array_index(std::filesystem::path const& path) : file{path} {
+        if (file.size() < sizeof(sa_header)) {
+            throw std::runtime_error(path.string() + " is too small to be a suffix array index");
+        }
+        header = reinterpret_cast<sa_header const*>(file.data());
+        if (std::memcmp(header->magic, sa_magic, sizeof(sa_magic)) != 0) {
+            throw std::runtime_error(path.string() + " is not a suffix array index");
+        }
+        if (header->version != sa_version || header->header_size != sizeof(sa_header)) {
+            throw std::runtime_error(path.string() + " has unsupported suffix array index version "
+                                     + std::to_string(header->version));
+        }
+        if (header->sa_width != sizeof(saidx_t) && header->sa_width != sizeof(saidx64_t)) {
+            throw std::runtime_error(path.string() + " has an unsupported suffix array width");
+        }
+        if (file.size() < header->sa_offset + header->text_length * header->sa_width) {
+            throw std::runtime_error(path.string() + " is truncated");
+        }
+    }
+
+    packed_reference_view text() const {
+        return {reinterpret_cast<uint64_t const*>(file.data() + header->words_offset),
+                reinterpret_cast<n_run const*>(file.data() + header->runs_offset),
+                header->text_length,
+                header->run_count};
+    }
+
+    // bytes per suffix array entry, sizeof(saidx_t) or sizeof(saidx64_t)
+    uint64_t sa_width() const { return header->sa_width; }
+
+    template <typename sa_value_t>
+    sa_value_t const* suffix_array() const {
+        if (sizeof(sa_value_t) != header->sa_width) {
+            throw std::logic_error("suffix array accessed with the wrong entry width");
+        }
+        return reinterpret_cast<sa_value_t const*>(file.data() + header->sa_offset);
+    }
+
+    uint64_t sequence_count() const { return header->sequence_count; }
+    uint64_t sequence_start(uint64_t id) const { return boundaries().start(id); }
+    sequence_boundaries boundaries() const {
+        return {reinterpret_cast<uint64_t const*>(file.data() + header->sequence_starts_offset), header->sequence_count};
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+#include "packed_reference.hpp"
+
+// Binary searches over a suffix array using the mlr trick of Manber and Myers: every suffix between
+// the left and right boundary of the search interval shares at least min(llcp, rlcp) characters with
+// the query, so the comparison at mid can skip those characters.
+// Suffixes end at the end of their sequence, like in build_suffix_array, so no match crosses a sequence border.
+
+// number of characters the suffix at pos shares with query, up to the end of its sequence
+template <typename query_t>
+size_t sa_lcp(packed_reference_view text, sequence_boundaries boundaries, uint64_t pos, query_t const& query,
+              size_t from, uint64_t& sequence_end) {
+    sequence_end = boundaries.end(boundaries.sequence_of(pos));
+    return std::min<uint64_t>(text.lcp(pos, query, from), sequence_end - pos);
+}
+
+// first suffix array position whose suffix is not smaller than query
+template <typename sa_value_t, typename query_t>
+uint64_t sa_lower_bound(packed_reference_view text, sequence_boundaries boundaries, sa_value_t const* suffixarray,
+                        uint64_t lo, uint64_t hi, query_t const& query) {
+    size_t llcp = 0, rlcp = 0;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        uint64_t pos = static_cast<uint64_t>(suffixarray[mid]);
+        uint64_t end;
+        size_t lcp = sa_lcp(text, boundaries, pos, query, std::min(llcp, rlcp), end);
+        // the suffix is smaller, if it is a proper prefix of the query or has a smaller character at lcp
+        bool smaller = lcp < query.size()
+                       && (pos + lcp == end || text.rank(pos + lcp) < seqan3::to_rank(query[lcp]));
+        if (smaller) {
+            lo = mid + 1;
+            llcp = lcp;
+        } else {
+            hi = mid;
+            rlcp = lcp;
+        }
+    }
+    return lo;
+}
+
+// first suffix array position whose suffix is larger than query and does not start with it
+template <typename sa_value_t, typename query_t>
+uint64_t sa_upper_bound(packed_reference_view text, sequence_boundaries boundaries, sa_value_t const* suffixarray,
+                        uint64_t lo, uint64_t hi, query_t const& query) {
+    size_t llcp = 0, rlcp = 0;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        uint64_t pos = static_cast<uint64_t>(suffixarray[mid]);
+        uint64_t end;
+        size_t lcp = sa_lcp(text, boundaries, pos, query, std::min(llcp, rlcp), end);
+        bool not_larger = lcp == query.size()
+                          || pos + lcp == end
+                          || text.rank(pos + lcp) < seqan3::to_rank(query[lcp]);
+        if (not_larger) {
+            lo = mid + 1;
+            llcp = lcp;
+        } else {
+            hi = mid;
+            rlcp = lcp;
+        }
+    }
+    return lo;
+}
+
+// suffix array interval [first, second) of all suffixes starting with query
+template <typename sa_value_t, typename query_t>
+std::pair<uint64_t, uint64_t> sa_equal_range(packed_reference_view text, sequence_boundaries boundaries,
+                                             sa_value_t const* suffixarray, query_t const& query) {
+    uint64_t lower = sa_lower_bound(text, boundaries, suffixarray, 0, text.size(), query);
+    uint64_t upper = sa_upper_bound(text, boundaries, suffixarray, lower, text.size(), query);
+    return {lower, upper};
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <divsufsort.h>
+#include <divsufsort64.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "parallel.hpp"
+
+// texts longer than this need the 64-bit suffix array (e.g. the full GRCh38)
+inline bool needs_64bit_suffix_array(uint64_t text_length) {
+    return text_length > static_cast<uint64_t>(std::numeric_limits<saidx_t>::max());
+}
+
+// suffix array of text with entries of type saidx_t (divsufsort) or saidx64_t (divsufsort64)
+template <typename sa_value_t>
+std::vector<sa_value_t> suffix_sort(std::vector<sauchar_t> const& text) {
+    static_assert(std::is_same_v<sa_value_t, saidx_t> || std::is_same_v<sa_value_t, saidx64_t>);
+    if (text.size() > static_cast<uint64_t>(std::numeric_limits<sa_value_t>::max())) {
+        throw std::runtime_error("text too large for a suffix array with entries of "
+                                 + std::to_string(sizeof(sa_value_t)) + " bytes");
+    }
+    std::vector<sa_value_t> suffixarray(text.size());
+    saint_t result;
+    if constexpr (std::is_same_v<sa_value_t, saidx_t>) {
+        result = divsufsort(text.data(), suffixarray.data(), text.size());
+    } else {
+        result = divsufsort64(text.data(), suffixarray.data(), text.size());
+    }
+    if (result != 0) {
+        throw std::runtime_error("suffix array construction failed");
+    }
+    return suffixarray;
+}
+
+// Suffix sorting for texts whose suffix array does not fit into memory next to the text.
+// Suffixes are distributed into buckets by their first symbols. Every pass collects the positions of as many
+// consecutive buckets as fit into the workspace and sorts the buckets in parallel by comparing suffixes directly,
+// 8 symbols at a time. Runs with a period of up to max_skipped_period symbols (N gaps, homopolymers and
+// microsatellites) are skipped in one step, so they do not make the comparisons quadratic; tandem repeats with
+// longer periods are compared symbol by symbol and sort slowly. A bucket larger than the workspace is sorted in
+// several passes over the text. The result is the same suffix array divsufsort computes.
+
+// stretches of a text that repeat with a short period and are long enough to be skipped while comparing suffixes
+struct symbol_run {
+    uint64_t begin;
+    uint64_t end;
+};
+
+inline constexpr uint64_t min_skipped_run = 64;
+inline constexpr size_t max_skipped_period = 6;
+
+// runs[p] holds the maximal runs of period p, [begin, end) with text[i] == text[i - p] for i in [begin + p, end)
+using periodic_runs = std::array<std::vector<symbol_run>, max_skipped_period + 1>;
+
+inline periodic_runs long_periodic_runs(std::vector<sauchar_t> const& text, size_t threads = 1) {
+    periodic_runs runs;
+    parallel_for_each_index(max_skipped_period, threads, [&](size_t index) {
+        uint64_t const p = index + 1;
+        for (uint64_t i = p; i < text.size();) {
+            if (text[i] != text[i - p]) {
+                ++i;
+                continue;
+            }
+            uint64_t j = i + 1;
+            while (j < text.size() && text[j] == text[j - p]) ++j;
+            if (j - (i - p) >= min_skipped_run) runs[p].push_back({i - p, j});
+            i = j;
+        }
+    });
+    return runs;
+}
+
+// number of symbols from i to the end of the run containing i, 0 if i is in none
+inline uint64_t long_run_remaining(std::vector<symbol_run> const& runs, uint64_t i) {
+    auto run = std::partition_point(runs.begin(), runs.end(), [i](symbol_run const& r) { return r.end <= i; });
+    return run != runs.end() && run->begin <= i ? run->end - i : 0;
+}
+
+// smallest period of up to max_skipped_period symbols of the 8 symbols in word, 0 if there is none
+inline size_t word_period(uint64_t word) {
+    for (size_t p = 1; p <= max_skipped_period; ++p) {
+        uint64_t const shift = 8 * p;
+        uint64_t const mask = (uint64_t{1} << (64 - shift)) - 1;
+        if constexpr (std::endian::native == std::endian::little) {
+            if ((word >> shift) == (word & mask)) return p;
+        } else {
+            if ((word << shift) == (word & ~mask)) return p;
+        }
+    }
+    return 0;
+}
+
+// true if the suffix at a is smaller than the one at b, both are known to start with the same `from` symbols
+inline bool suffix_less(std::vector<sauchar_t> const& text, periodic_runs const& runs,
+                        uint64_t a, uint64_t b, uint64_t from) {
+    uint64_t const n = text.size();
+    uint64_t i = a + from;
+    uint64_t j = b + from;
+    while (true) {
+        if (j >= n) return false;
+        if (i >= n) return true;
+        if (std::min(n - i, n - j) < 8) {
+            if (text[i] != text[j]) return text[i] < text[j];
+            ++i;
+            ++j;
+            continue;
+        }
+        uint64_t x, y;
+        std::memcpy(&x, text.data() + i, 8);
+        std::memcpy(&y, text.data() + j, 8);
+        if (x != y) {
+            if constexpr (std::endian::native == std::endian::little) {
+                return __builtin_bswap64(x) < __builtin_bswap64(y);
+            } else {
+                return x < y;
+            }
+        }
+        // both suffixes start with the same period, they agree as long as both of them stay in a run of it
+        uint64_t skip = 8;
+        if (size_t p = word_period(x); p != 0) {
+            skip = std::max(skip, std::min(long_run_remaining(runs[p], i), long_run_remaining(runs[p], j)));
+        }
+        i += skip;
+        j += skip;
+    }
+}
+
+// sorts all suffixes of text (symbols < sigma) and calls emit(begin, end) with consecutive parts of the suffix array;
+// the bucket tables and the positions of one pass take at most workspace_bytes
+template <typename sa_value_t, typename emit_t>
+void bucketed_suffix_sort(std::vector<sauchar_t> const& text, size_t sigma, uint64_t workspace_bytes, size_t threads,
+                          emit_t&& emit) {
+    uint64_t const n = text.size();
+    // bucket ids are the first `prefix` symbols + 1 in base sigma + 1, 0 pads suffixes shorter than prefix;
+    // the counts, offsets and cursors of the buckets take at most a quarter of the workspace
+    uint64_t const base = sigma + 1;
+    uint64_t prefix = 1;
+    uint64_t bucket_count = base;
+    while (bucket_count * base <= (uint64_t{1} << 20)
+           && 3 * bucket_count * base * sizeof(uint64_t) <= workspace_bytes / 4) {
+        bucket_count *= base;
+        prefix++;
+    }
+    uint64_t const table_bytes = 3 * bucket_count * sizeof(uint64_t);
+    if (workspace_bytes < table_bytes + sizeof(sa_value_t)) {
+        throw std::runtime_error("the sort workspace is too small for suffix sorting, it needs at least "
+                                 + std::to_string(table_bytes + sizeof(sa_value_t)) + " bytes");
+    }
+    uint64_t const capacity = (workspace_bytes - table_bytes) / sizeof(sa_value_t);
+
+    uint64_t const top = bucket_count / base;
+    auto value = [&](uint64_t i) -> uint64_t { return i < n ? text[i] + 1 : 0; };
+    auto for_each_bucket_id = [&](auto&& fn) {
+        uint64_t id = 0;
+        for (uint64_t t = 0; t < prefix; ++t) id = id * base + value(t);
+        for (uint64_t i = 0; i < n; ++i) {
+            fn(i, id);
+            id = (id - value(i) * top) * base + value(i + prefix);
+        }
+    };
+
+    std::vector<uint64_t> counts(bucket_count, 0);
+    for_each_bucket_id([&](uint64_t, uint64_t id) { counts[id]++; });
+
+    auto const runs = long_periodic_runs(text, threads);
+    auto less = [&](sa_value_t x, sa_value_t y) { return suffix_less(text, runs, x, y, prefix); };
+    std::vector<sa_value_t> positions;
+    std::vector<uint64_t> offsets;
+    for (uint64_t first = 0; first < bucket_count;) {
+        if (counts[first] > capacity) {
+            // every pass keeps the `capacity` smallest suffixes of the bucket above the last emitted one in a max-heap
+            positions.reserve(capacity);
+            for (uint64_t emitted = 0; emitted < counts[first]; emitted += positions.size()) {
+                bool const above = emitted > 0;
+                sa_value_t const lower = above ? positions.back() : 0;
+                positions.clear();
+                for_each_bucket_id([&](uint64_t i, uint64_t id) {
+                    sa_value_t const position = static_cast<sa_value_t>(i);
+                    if (id != first || (above && !less(lower, position))) return;
+                    if (positions.size() < capacity) {
+                        positions.push_back(position);
+                        std::push_heap(positions.begin(), positions.end(), less);
+                    } else if (less(position, positions.front())) {
+                        std::pop_heap(positions.begin(), positions.end(), less);
+                        positions.back() = position;
+                        std::push_heap(positions.begin(), positions.end(), less);
+                    }
+                });
+                std::sort_heap(positions.begin(), positions.end(), less);
+                emit(positions.data(), positions.data() + positions.size());
+            }
+            first++;
+            continue;
+        }
+        // buckets [first, last) form the next pass
+        uint64_t last = first;
+        uint64_t total = 0;
+        while (last < bucket_count && total + counts[last] <= capacity) {
+            total += counts[last++];
+        }
+        offsets.assign(last - first + 1, 0);
+        for (uint64_t b = first; b < last; ++b) {
+            offsets[b - first + 1] = offsets[b - first] + counts[b];
+        }
+        positions.resize(total);
+        std::vector<uint64_t> cursors(offsets.begin(), offsets.end() - 1);
+        for_each_bucket_id([&](uint64_t i, uint64_t id) {
+            if (id >= first && id < last) {
+                positions[cursors[id - first]++] = static_cast<sa_value_t>(i);
+            }
+        });
+        parallel_for_each_index(last - first, threads, [&](size_t b) {
+            std::sort(positions.begin() + offsets[b], positions.begin() + offsets[b + 1], less);
+        });
+        emit(positions.data(), positions.data() + positions.size());
+        first = last;
+    }
+}
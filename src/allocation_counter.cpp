@@ -0,0 +1,42 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.hpp"
+
+namespace {
+
+thread_local uint64_t allocations = 0;
+
+void* counted_allocation(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc{};
+}
+
+void* counted_allocation(std::size_t size, std::align_val_t alignment) {
+    ++allocations;
+    std::size_t a = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+    throw std::bad_alloc{};
+}
+
+} // namespace
+
+uint64_t thread_allocation_count() {
+    return allocations;
+}
+
+// the array and nothrow forms of the standard library forward to these
+void* operator new(std::size_t size) { return counted_allocation(size); }
+void* operator new[](std::size_t size) { return counted_allocation(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return counted_allocation(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return counted_allocation(size, alignment); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
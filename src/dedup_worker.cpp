@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "query_cache.hpp"
+#include "search_engine.hpp"
+
+namespace {
+
+// everything a search reports for one query sequence
+struct query_result {
+    uint64_t count = 0;
+    bool located = false; // hits holds every hit, a counting search leaves it empty
+    std::vector<hit> hits;
+};
+
+// collects the hits of a chunk together with the number of the query they belong to
+class hit_collector : public hit_sink {
+public:
+    std::vector<std::vector<seqan3::dna5>> const* queries = nullptr;
+    std::vector<std::pair<size_t, hit>> hits;
+
+    void add(std::string_view, std::vector<seqan3::dna5> const& query, hit const& h) override {
+        hits.emplace_back(&query - queries->data(), h);
+    }
+};
+
+// searches every distinct query of a chunk once and hands its result to all copies
+// the distinct queries the cache does not know are searched together as one chunk, so the wrapped worker still
+// sees whole chunks; the results of recent queries are kept across chunks, each worker has its own cache so
+// lookups take no lock
+class dedup_worker : public search_worker {
+    std::unique_ptr<search_worker> worker_;
+    query_lru_cache<std::shared_ptr<query_result const>> cache_;
+    std::unordered_map<std::vector<seqan3::dna5> const*, size_t, packed_query_hash, query_pointer_equal> distinct_;
+    std::vector<size_t> representatives_; // first query of every distinct query
+    std::vector<std::shared_ptr<query_result const>> results_;
+    std::vector<size_t> distinct_of_query_;
+    query_chunk misses_{0, 0, {}, {}}; // the distinct queries missing from the cache
+    std::vector<size_t> distinct_of_miss_;
+    std::vector<uint64_t> miss_counts_;
+    hit_collector collector_;
+
+    // searches the misses in one call and caches their results
+    void search_misses(bool locate) {
+        size_t const misses = distinct_of_miss_.size();
+        misses_.queries.resize(misses);
+        misses_.ids.resize(misses);
+        miss_counts_.assign(misses, 0);
+        collector_.queries = &misses_.queries;
+        collector_.hits.clear();
+        worker_->search(misses_, locate ? &collector_ : nullptr, miss_counts_);
+        // hits keep the order the worker reported them in within every query
+        std::stable_sort(collector_.hits.begin(), collector_.hits.end(),
+                         [](auto const& a, auto const& b) { return a.first < b.first; });
+        auto next_hit = collector_.hits.begin();
+        for (size_t m = 0; m < misses; ++m) {
+            auto result = std::make_shared<query_result>();
+            result->count = miss_counts_[m];
+            result->located = locate;
+            for (; next_hit != collector_.hits.end() && next_hit->first == m; ++next_hit) {
+                result->hits.push_back(next_hit->second);
+            }
+            cache_.put(misses_.queries[m], result);
+            results_[distinct_of_miss_[m]] = std::move(result);
+        }
+    }
+
+public:
+    dedup_worker(std::unique_ptr<search_worker> worker, size_t cache_capacity)
+        : worker_{std::move(worker)}, cache_{cache_capacity} {}
+
+    uint64_t search(query_chunk const& chunk, hit_sink* hits, std::span<uint64_t> query_counts) override {
+        auto const& queries = chunk.queries;
+        distinct_.clear();
+        representatives_.clear();
+        distinct_of_query_.resize(queries.size());
+        for (size_t q = 0; q < queries.size(); ++q) {
+            auto [found, inserted] = distinct_.try_emplace(&queries[q], representatives_.size());
+            if (inserted) representatives_.push_back(q);
+            distinct_of_query_[q] = found->second;
+        }
+
+        bool const locate = hits != nullptr;
+        results_.assign(representatives_.size(), nullptr);
+        distinct_of_miss_.clear();
+        for (size_t d = 0; d < representatives_.size(); ++d) {
+            size_t q = representatives_[d];
+            if (auto cached = cache_.find(queries[q]); cached && ((*cached)->located || !locate)) {
+                results_[d] = *cached;
+                continue;
+            }
+            size_t m = distinct_of_miss_.size();
+            distinct_of_miss_.push_back(d);
+            misses_.queries.resize(std::max(misses_.queries.size(), m + 1));
+            misses_.ids.resize(std::max(misses_.ids.size(), m + 1));
+            misses_.queries[m] = queries[q];
+            misses_.ids[m] = chunk.ids[q];
+        }
+        if (!distinct_of_miss_.empty()) search_misses(locate);
+
+        uint64_t count = 0;
+        for (size_t q = 0; q < queries.size(); ++q) {
+            auto const& result = *results_[distinct_of_query_[q]];
+            count += result.count;
+            if (!query_counts.empty()) query_counts[q] += result.count;
+            if (!hits) continue;
+            for (auto const& h : result.hits) {
+                hits->add(chunk.ids[q], queries[q], h);
+            }
+        }
+        return count;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<search_worker> make_dedup_worker(std::unique_ptr<search_worker> worker, size_t cache_capacity) {
+    return std::make_unique<dedup_worker>(std::move(worker), cache_capacity);
+}
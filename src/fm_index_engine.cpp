@@ -0,0 +1,210 @@
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+#include <seqan3/core/debug_stream.hpp>
+#include <seqan3/search/fm_index/bi_fm_index.hpp>
+#include <seqan3/search/fm_index/fm_index.hpp>
+#include <seqan3/search/search.hpp>
+
+#include "flat_fm_index.hpp"
+#include "search_engine.hpp"
+#include "search_scheme.hpp"
+#include "strand.hpp"
+
+namespace {
+
+class fm_index_engine : public search_engine {
+    using Index = decltype(seqan3::fm_index{std::vector<std::vector<seqan3::dna5>>{}}); // Some hack
+    using BiIndex = decltype(seqan3::bi_fm_index{std::vector<std::vector<seqan3::dna5>>{}});
+
+    Index index_; // construct fm-index
+    BiIndex bi_index_; // used instead, if --bi-fm-index 1
+    std::optional<flat_fm_index> flat_index_; // used instead, if the index file is in the flat (mmap) format
+    search_scheme scheme_;
+    unsigned char bi_fm_index_;
+    unsigned char errors_;
+    strand_mode mode_;
+
+    class worker : public search_worker {
+        fm_index_engine const& engine_;
+        std::vector<seqan3::dna5> reverse_query_;
+        std::vector<std::vector<seqan3::dna5>> oriented_;
+
+    public:
+        explicit worker(fm_index_engine const& engine) : engine_{engine} {}
+
+        uint64_t search(query_chunk const& chunk, hit_sink* hits, std::span<uint64_t> query_counts) override {
+            auto const& block = chunk.queries;
+            auto const mode = engine_.mode_;
+            size_t const errors = engine_.errors_;
+            uint64_t count = 0;
+            auto add_hit = [&](size_t q, char strand, size_t reference_id, size_t position, size_t hit_errors) {
+                hits->add(chunk.ids[q], block[q], hit{reference_id, position, strand, hit_errors, false});
+            };
+            auto add_count = [&](size_t q, uint64_t found) {
+                count += found;
+                if (!query_counts.empty()) query_counts[q] += found;
+            };
+            // both orientations of every query are searched in the same pass over the chunk
+            auto for_each_orientation = [&](size_t q, auto&& fn) {
+                for (char strand : strands(mode)) {
+                    if (strand == '-') reverse_complement(block[q], reverse_query_);
+                    fn(strand, strand == '+' ? block[q] : reverse_query_);
+                }
+            };
+            auto const& flat_index = engine_.flat_index_;
+            if (flat_index && flat_index->has_reverse_complement()) {
+                // the index holds the reverse complement of the reference, so a single backward search finds a
+                // read on both strands: its occurrences on the reverse complements are the reverse strand hits
+                for (size_t q = 0; q < block.size(); ++q) {
+                    flat_index->search(block[q], errors, [&](uint64_t sp, uint64_t ep, size_t hit_errors) {
+                        if (!hits && mode == strand_mode::both) {
+                            add_count(q, ep - sp);
+                            return;
+                        }
+                        for (uint64_t i = sp; i < ep; ++i) {
+                            auto position = flat_index->to_sequence_position(flat_index->locate(i));
+                            bool reverse = position.sequence_id >= flat_index->sequence_count();
+                            if (reverse ? mode == strand_mode::forward : mode == strand_mode::reverse) continue;
+                            if (reverse) position = flat_index->forward_position(position, block[q].size());
+                            if (hits) add_hit(q, reverse ? '-' : '+', position.sequence_id, position.offset, hit_errors);
+                            add_count(q, 1);
+                        }
+                    });
+                }
+            } else if (flat_index && hits) {
+                for (size_t q = 0; q < block.size(); ++q) {
+                    for_each_orientation(q, [&](char strand, auto const& query) {
+                        flat_index->search(query, errors, [&](uint64_t sp, uint64_t ep, size_t hit_errors) {
+                            for (uint64_t i = sp; i < ep; ++i) {
+                                auto [reference_id, position] = flat_index->to_sequence_position(flat_index->locate(i));
+                                add_hit(q, strand, reference_id, position, hit_errors);
+                            }
+                            add_count(q, ep - sp);
+                        });
+                    });
+                }
+            } else if (flat_index) {
+                for (size_t q = 0; q < block.size(); ++q) {
+                    for_each_orientation(q, [&](char, auto const& query) {
+                        add_count(q, flat_index->count(query, errors));
+                    });
+                }
+            } else if (!engine_.scheme_.empty()) {
+                for (size_t q = 0; q < block.size(); ++q) {
+                    for_each_orientation(q, [&](char strand, auto const& query) {
+                        auto located = locate_with_scheme(engine_.bi_index_, query, engine_.scheme_);
+                        if (hits) {
+                            for (auto [reference_id, position, hit_errors] : located) {
+                                add_hit(q, strand, reference_id, position, hit_errors);
+                            }
+                        }
+                        add_count(q, located.size());
+                    });
+                }
+            } else {
+                // configure to use hamming distance
+                seqan3::configuration const cfg = seqan3::search_cfg::max_error_total{seqan3::search_cfg::error_count{engine_.errors_}}
+                                                    | seqan3::search_cfg::max_error_substitution{seqan3::search_cfg::error_count{engine_.errors_}}
+                                                    | seqan3::search_cfg::max_error_insertion{seqan3::search_cfg::error_count{0}}
+                                                    | seqan3::search_cfg::max_error_deletion{seqan3::search_cfg::error_count{0}};
+                // backtracking through a seqan3 index does not report the errors of a hit
+                size_t const seqan3_errors = errors == 0 ? 0 : hit_unknown_errors;
+                // seqan3 searches the forward queries followed by the reverse complements as one collection,
+                // result query ids past the forward queries belong to the reverse strand
+                oriented_.clear();
+                if (mode != strand_mode::forward) {
+                    if (mode == strand_mode::both) oriented_ = block;
+                    for (auto const& query : block) {
+                        reverse_complement(query, reverse_query_);
+                        oriented_.push_back(reverse_query_);
+                    }
+                }
+                auto const& searched = mode == strand_mode::forward ? block : oriented_;
+                size_t const forward_count = mode == strand_mode::reverse ? 0 : block.size();
+                auto search_with = [&](auto const& seqan3_index) {
+                    for (auto && result : seqan3::search(searched, seqan3_index, cfg)) {
+                        size_t id = result.query_id();
+                        bool reverse = id >= forward_count;
+                        size_t q = reverse ? id - forward_count : id;
+                        if (hits) {
+                            add_hit(q, reverse ? '-' : '+', result.reference_id(), result.reference_begin_position(), seqan3_errors);
+                        }
+                        add_count(q, 1);
+                    }
+                };
+                if (engine_.bi_fm_index_ == 1) {
+                    search_with(engine_.bi_index_);
+                } else {
+                    search_with(engine_.index_);
+                }
+            }
+            return count;
+        }
+    };
+
+public:
+    explicit fm_index_engine(search_options const& options)
+        : bi_fm_index_{options.bi_fm_index}, errors_{options.errors}, mode_{parse_strand_mode(options.strand)} {
+        if (bi_fm_index_ != 0 && bi_fm_index_ != 1) {
+            throw std::runtime_error("bi_fm_index must be either 0 or 1");
+        }
+        if (!options.search_scheme.empty()) {
+            if (bi_fm_index_ != 1) {
+                throw std::runtime_error("search schemes need a bi-fm-index");
+            }
+            if (is_flat_fm_index(options.index_path)) {
+                throw std::runtime_error("search schemes need a seqan3 bi-fm-index");
+            }
+            scheme_ = make_search_scheme(options.search_scheme, options.errors);
+            check_search_scheme(scheme_, options.errors);
+        }
+
+        // loading fm-index into memory
+        if (is_flat_fm_index(options.index_path)) {
+            seqan3::debug_stream << "Mapping flat FM-Index ... " << std::flush;
+            flat_index_.emplace(options.index_path);
+            seqan3::debug_stream << "done\n";
+        } else if (bi_fm_index_ == 1) {
+            // searching a bi-fm-index with errors uses optimum search schemes instead of backtracking
+            seqan3::debug_stream << "Loading Bi-2FM-Index ... " << std::flush;
+            std::ifstream is{options.index_path, std::ios::binary};
+            cereal::BinaryInputArchive iarchive{is};
+            iarchive(bi_index_);
+            seqan3::debug_stream << "done\n";
+        } else {
+            seqan3::debug_stream << "Loading 2FM-Index ... " << std::flush;
+            std::ifstream is{options.index_path, std::ios::binary};
+            cereal::BinaryInputArchive iarchive{is};
+            iarchive(index_);
+            seqan3::debug_stream << "done\n";
+        }
+    }
+
+    std::string method() const override {
+        if (flat_index_) return "Flat-FM-Index";
+        if (!scheme_.empty()) return "Bi-FM-Index-Search-Scheme";
+        if (bi_fm_index_ == 1) return "Bi-FM-Index";
+        return "FM-Index";
+    }
+
+    std::vector<uint64_t> sequence_lengths() const override {
+        std::vector<uint64_t> lengths;
+        for (uint64_t id = 0; flat_index_ && id < flat_index_->sequence_count(); ++id) {
+            lengths.push_back(flat_index_->sequence_length(id));
+        }
+        return lengths;
+    }
+
+    std::unique_ptr<search_worker> make_worker() const override {
+        return std::make_unique<worker>(*this);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<search_engine> make_fm_index_engine(search_options const& options) {
+    return std::make_unique<fm_index_engine>(options);
+}
@@ -1,15 +1,20 @@
 #include <sstream>
 
 #include <filesystem>
+#include <limits>
 #include <stdexcept>
 
 #include <seqan3/alphabet/nucleotide/dna5.hpp>
 #include <seqan3/argument_parser/all.hpp>
 #include <seqan3/core/debug_stream.hpp>
 #include <seqan3/io/sequence_file/all.hpp>
+#include <seqan3/search/fm_index/bi_fm_index.hpp>
 #include <seqan3/search/fm_index/fm_index.hpp>
 #include <seqan3/search/search.hpp>
 
+#include "flat_fm_index_builder.hpp"
+#include "gzip_input.hpp"
+
 int main(int argc, char const* const* argv) {
     seqan3::argument_parser parser{"fmindex_construct", argc, argv, seqan3::update_notifications::off};
 
@@ -26,6 +31,20 @@ int main(int argc, char const* const* argv) {
     unsigned char bi_fm_index = 0;
     parser.add_option(bi_fm_index, bi_fm_index, "bi-fm-index", "create a fm-index (0); create bi-fm-index (1)");
 
+    std::string format = "cereal";
+    parser.add_option(format, '\0', "format", "on-disk format: seqan3 index archive (cereal); flat index that can be mmap'ed (mmap)");
+
+    uint64_t sa_sample_rate = 16;
+    parser.add_option(sa_sample_rate, '\0', "sa-sampling", "sample every n-th suffix array value of the mmap format; smaller is faster to locate, larger is smaller on disk");
+
+    uint64_t sort_memory = 0;
+    parser.add_option(sort_memory, '\0', "sort-memory", "workspace of the suffix sort of the mmap format in MiB; if the whole suffix array does not fit, it is sorted in buckets within this limit. The text (one byte per base), the packed reference, the suffix array samples and the reference parser come on top of it, so this is no bound on the peak memory (0: no limit)");
+
+    unsigned char reverse_complement = 0;
+    parser.add_option(reverse_complement, '\0', "reverse-complement", "also index the reverse complement of the reference in the mmap format (1), so --strand both searches every read once; doubles the index (0: forward only)");
+
+    unsigned int threads = 1;
+    parser.add_option(threads, '\0', "threads", "number of threads inflating a bgzf reference and sorting buckets of the suffix array; the latter only if --sort-memory is too small for the whole suffix array");
 
     try {
          parser.parse();
@@ -38,9 +57,45 @@ int main(int argc, char const* const* argv) {
     if (bi_fm_index != 0 && bi_fm_index != 1) {
         throw std::runtime_error("bi_fm_index must be either 0 or 1");
     }
+    if (format != "cereal" && format != "mmap") {
+        throw std::runtime_error("format must be either cereal or mmap");
+    }
+    if (format == "mmap" && bi_fm_index == 1) {
+        throw std::runtime_error("the mmap format only supports unidirectional fm-indices");
+    }
+    if (reverse_complement != 0 && reverse_complement != 1) {
+        throw std::runtime_error("reverse_complement must be either 0 or 1");
+    }
+    if (format != "mmap" && reverse_complement == 1) {
+        throw std::runtime_error("only the mmap format can index the reverse complement");
+    }
+    if (sa_sample_rate == 0) {
+        throw std::runtime_error("sa-sampling must be at least 1");
+    }
+    if (threads == 0) {
+        throw std::runtime_error("threads must be at least 1");
+    }
+    if (sort_memory > (std::numeric_limits<uint64_t>::max() >> 20)) {
+        throw std::runtime_error("sort-memory must be at most " + std::to_string(std::numeric_limits<uint64_t>::max() >> 20) + " MiB");
+    }
 
     // loading our files
-    auto reference_stream = seqan3::sequence_file_input{reference_file};
+    auto reference_stream = sequence_input{reference_file, threads};
+
+    if (format == "mmap") {
+        // the sequences go straight into the index text, one byte per base
+        flat_fm_text text;
+        for (auto& record : reference_stream) {
+            text.append(record.sequence());
+        }
+        if (reverse_complement == 1) {
+            text.append_reverse_complements();
+        }
+        seqan3::debug_stream << "Saving flat FM-Index ... " << std::flush;
+        build_flat_fm_index(text, index_path, sa_sample_rate, sort_memory << 20, threads);
+        seqan3::debug_stream << "done\n";
+        return 0;
+    }
 
     // read reference into memory
     std::vector<std::vector<seqan3::dna5>> reference;
@@ -50,7 +105,7 @@ int main(int argc, char const* const* argv) {
 
     // Our index is of type `Index`
     if (bi_fm_index == 1) {
-        seqan3::fm_index bi_index{reference}; // bidirectional index on single text
+        seqan3::bi_fm_index bi_index{reference}; // bidirectional index over the text collection
         seqan3::debug_stream << "Saving Bi-2FM-Index ... " << std::flush;
         std::ofstream os{index_path, std::ios::binary};
         cereal::BinaryOutputArchive oarchive{os};
@@ -1,98 +1,20 @@
-#include <sstream>
+#include <iostream>
 
-#include <filesystem>
-
-#include <seqan3/alphabet/nucleotide/dna5.hpp>
-#include <seqan3/argument_parser/all.hpp>
-#include <seqan3/core/debug_stream.hpp>
-#include <seqan3/io/sequence_file/all.hpp>
-#include <seqan3/search/fm_index/fm_index.hpp>
-#include <seqan3/search/search.hpp>
+#include "search_engine.hpp"
 
 int main(int argc, char const* const* argv) {
-    using std::chrono::high_resolution_clock;
-    using std::chrono::duration_cast;
-    using std::chrono::duration;
-    using std::chrono::nanoseconds;
     seqan3::argument_parser parser{"fmindex_search", argc, argv, seqan3::update_notifications::off};
-
-    parser.info.author = "SeqAn-Team";
-    parser.info.version = "1.0.0";
-
-    auto index_path = std::filesystem::path{};
-    parser.add_option(index_path, '\0', "index", "path to the query file");
-
-    auto query_file = std::filesystem::path{};
-    parser.add_option(query_file, '\0', "query", "path to the query file");
-
-    unsigned long int query_length = 100;
-    parser.add_option(query_length, query_length, "query-lim", "query limit");
-
-    unsigned char max_error_total = 0;
-    parser.add_option(max_error_total, max_error_total, "error-total", "number of total errors");
-
-    unsigned char bi_fm_index = 0;
-    parser.add_option(bi_fm_index, bi_fm_index, "bi-fm-index", "create a fm-index (0); create bi-fm-index (1)");
-
-    try {
-         parser.parse();
-    } catch (seqan3::argument_parser_error const& ext) {
-        seqan3::debug_stream << "Parsing error. " << ext.what() << "\n";
-        return EXIT_FAILURE;
-    }
-
-    // loading our files
-    auto query_stream = seqan3::sequence_file_input{query_file};
-
-    // read query into memory
-    std::vector<std::vector<seqan3::dna5>> queries;
-    for (auto& record : query_stream) {
-        queries.push_back(record.sequence());
-        if (queries.size() == query_length) break;
-    }
-
-    size_t remaining = query_length - queries.size();
-    for (size_t i = 0; i < remaining; ++i) {
-        queries.push_back(queries[i]);
-    }
-
-    // loading fm-index into memory
-    using Index = decltype(seqan3::fm_index{std::vector<std::vector<seqan3::dna5>>{}}); // Some hack
-    Index index; // construct fm-index
-    {
-        seqan3::debug_stream << "Loading 2FM-Index ... " << std::flush;
-        std::ifstream is{index_path, std::ios::binary};
-        cereal::BinaryInputArchive iarchive{is};
-        iarchive(index);
-        seqan3::debug_stream << "done\n";
-    }
-    //!TODO here adjust the number of searches
-
-    // configure to use hamming distance
-    seqan3::configuration const cfg = seqan3::search_cfg::max_error_total{seqan3::search_cfg::error_count{max_error_total}}
-                                        | seqan3::search_cfg::max_error_substitution{seqan3::search_cfg::error_count{max_error_total}}
-                                        | seqan3::search_cfg::max_error_insertion{seqan3::search_cfg::error_count{0}}
-                                        | seqan3::search_cfg::max_error_deletion{seqan3::search_cfg::error_count{0}};
-    auto t1 = high_resolution_clock::now();
-    auto results = search(queries, index, cfg);
-    unsigned int total_count = 0;
-    for (auto && result : results) {
-        total_count++;
-    }
-    auto t2 = high_resolution_clock::now();  
-    auto t_diff = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1);
-    std::cout << ">>>>>" << std::endl;
-    if (bi_fm_index == 1) {
-        std::cout << "> Method: Bi-FM-Index" << std::endl;
-    } else {
-        std::cout << "> Method: FM-Index" << std::endl;
-    }
-    std::cout << "> Query File: " << query_file << std::endl;
-    std::cout << "> Query Limit: " << query_length << std::endl;
-    unsigned int max_error_total_int = (unsigned int) max_error_total;
-    std::cout << "> Excepted Errors: " << max_error_total_int << std::endl;
-    std::cout << "> Total Count: " << total_count << std::endl;
-    std::cout << "> Search duration: " << t_diff.count() << " ns\n";
-    std::cout << "<<<<" << std::endl;
+    init_parser(parser);
+
+    search_options options;
+    parser.add_option(options.index_path, '\0', "index", "path to the index file");
+    parser.add_option(options.errors, '\0', "error-total", "number of total errors");
+    parser.add_option(options.bi_fm_index, '\0', "bi-fm-index", "load a fm-index (0); load a bi-fm-index (1), searched with optimum search schemes");
+    parser.add_option(options.search_scheme, '\0', "search-scheme", "search the bi-fm-index with a search scheme: optimum (up to 4 errors), pigeon (k + 1 pieces), kucherov (up to 2 errors), 01*0 (up to 8 errors) or explicit, e.g. 12/00/01;21/01/01");
+    add_query_options(parser, options);
+    if (!parse_arguments(parser)) return EXIT_FAILURE;
+
+    auto engine = make_fm_index_engine(options);
+    print_report(std::cout, options, run_search(*engine, options));
     return 0;
 }
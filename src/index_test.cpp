@@ -0,0 +1,795 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+#include <seqan3/search/fm_index/fm_index.hpp>
+#include <seqan3/search/search.hpp>
+
+#include "aho_corasick.hpp"
+#include "flat_fm_index_builder.hpp"
+#include "hit_writer.hpp"
+#include "packed_reference.hpp"
+#include "query_stream.hpp"
+#include "search_engine.hpp"
+#include "search_scheme.hpp"
+#include "strand.hpp"
+#include "suffix_array_index.hpp"
+#include "suffix_array_search.hpp"
+#include "suffix_sort.hpp"
+
+// Compares the indexes, the pigeon engine and the flat fm-index engine against brute force scans of the indexed
+// sequences on random multi-sequence references.
+// Sequences get N runs, come from small alphabets or repeat a short unit, so matches cluster and cross sequence
+// borders. Exits with EXIT_FAILURE after the first few mismatches are printed.
+
+namespace {
+
+std::mt19937_64 rng{20240702};
+size_t checks = 0;
+size_t failures = 0;
+
+void check(bool ok, std::string const& what) {
+    ++checks;
+    if (ok) return;
+    if (++failures <= 20) std::cerr << "FAILED: " << what << '\n';
+}
+
+size_t uniform(size_t lo, size_t hi) {
+    return std::uniform_int_distribution<size_t>{lo, hi}(rng);
+}
+
+using sequence = std::vector<seqan3::dna5>;
+
+seqan3::dna5 base(uint8_t rank) {
+    return seqan3::assign_rank_to(rank, seqan3::dna5{});
+}
+
+// random bases over A and T or all of A, C, G and T, N runs and, for some sequences, a repeated short unit
+sequence random_sequence(size_t length) {
+    size_t sigma = uniform(0, 2) == 0 ? 2 : 4;
+    sequence s(length);
+    for (auto& c : s) c = base(std::array<uint8_t, 4>{0, 4, 1, 2}[uniform(0, sigma - 1)]);
+    if (uniform(0, 3) == 0 && length > 0) {
+        size_t unit = uniform(1, 7);
+        for (size_t i = unit; i < length; ++i) s[i] = s[i - unit];
+    }
+    for (size_t runs = uniform(0, 3); runs > 0 && length > 0; --runs) {
+        size_t begin = uniform(0, length - 1);
+        size_t end = std::min(length, begin + (uniform(0, 3) == 0 ? uniform(64, 200) : uniform(1, 5)));
+        for (size_t i = begin; i < end; ++i) s[i] = base(dna5_rank_n);
+    }
+    return s;
+}
+
+// 1 to 5 sequences, some of them only a few bases long
+std::vector<sequence> random_reference() {
+    std::vector<sequence> reference(uniform(1, 5));
+    for (auto& s : reference) s = random_sequence(uniform(0, 4) == 0 ? uniform(1, 8) : uniform(1, 1500));
+    return reference;
+}
+
+// a window of one of the sequences, or the end of one sequence followed by the start of the next, with up to
+// `substitutions` random substitutions
+sequence random_query(std::vector<sequence> const& reference, size_t substitutions) {
+    size_t id = uniform(0, reference.size() - 1);
+    auto const& s = reference[id];
+    size_t m = std::min(s.size(), uniform(1, 16));
+    size_t begin = uniform(0, s.size() - m);
+    sequence query(s.begin() + begin, s.begin() + begin + m);
+    if (id + 1 < reference.size() && uniform(0, 3) == 0) {
+        auto const& next = reference[id + 1];
+        query.assign(s.end() - m, s.end());
+        query.insert(query.end(), next.begin(), next.begin() + std::min(next.size(), uniform(1, 8)));
+    }
+    for (size_t e = 0; e < substitutions; ++e) query[uniform(0, query.size() - 1)] = base(uniform(0, 4));
+    return query;
+}
+
+size_t mismatches(sequence const& s, size_t pos, sequence const& query) {
+    size_t count = 0;
+    for (size_t j = 0; j < query.size(); ++j) count += s[pos + j] != query[j];
+    return count;
+}
+
+// (sequence id, offset) of every window of a sequence that matches query with at most `errors` substitutions
+std::vector<std::pair<uint64_t, uint64_t>> scan(std::vector<sequence> const& reference, sequence const& query,
+                                                size_t errors) {
+    std::vector<std::pair<uint64_t, uint64_t>> hits;
+    for (size_t id = 0; id < reference.size(); ++id) {
+        for (size_t pos = 0; pos + query.size() <= reference[id].size(); ++pos) {
+            if (mismatches(reference[id], pos, query) <= errors) hits.emplace_back(id, pos);
+        }
+    }
+    return hits;
+}
+
+std::vector<char> read_file(std::filesystem::path const& path) {
+    std::ifstream is{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}};
+}
+
+std::string describe(sequence const& query, size_t errors) {
+    return "query of length " + std::to_string(query.size()) + " with " + std::to_string(errors) + " errors";
+}
+
+// flat fm-index
+
+void test_flat_fm_index() {
+    auto path = std::filesystem::temp_directory_path() / ("index_test_" + std::to_string(rng()) + ".flat");
+    for (size_t trial = 0; trial < 300; ++trial) {
+        auto reference = random_reference();
+        flat_fm_text text;
+        for (auto const& s : reference) text.append(s);
+        bool const reverse = trial % 3 == 2;
+        if (reverse) text.append_reverse_complements();
+        // sample rates of 1 (every position sampled) up to more than the longest sequence
+        uint64_t sample_rate = std::array<uint64_t, 6>{1, 2, 3, 16, 64, 2000}[uniform(0, 5)];
+        build_flat_fm_index(text, path, sample_rate);
+        flat_fm_index index{path};
+        std::string where = " with sample rate " + std::to_string(sample_rate) + (reverse ? " and reverse complements" : "")
+                          + " in trial " + std::to_string(trial);
+
+        check(index.sequence_count() == reference.size(), "flat_fm_index::sequence_count" + where);
+        check(index.has_reverse_complement() == reverse, "flat_fm_index::has_reverse_complement" + where);
+        check(index.text().size() == text.packed.size(), "flat_fm_index::text holds the sequences only" + where);
+        for (size_t id = 0; id < reference.size() && id < index.sequence_count(); ++id) {
+            check(index.sequence_length(id) == reference[id].size(), "flat_fm_index::sequence_length" + where);
+        }
+
+        // locate of every bwt position hits every text position once, separators are the last position of a sequence
+        std::vector<uint64_t> located(index.size());
+        for (uint64_t i = 0; i < index.size(); ++i) located[i] = index.locate(i);
+        std::sort(located.begin(), located.end());
+        bool permutation = true;
+        for (uint64_t i = 0; i < located.size(); ++i) permutation &= located[i] == i;
+        check(permutation, "flat_fm_index::locate is no permutation of the text positions" + where);
+
+        for (size_t id = 0, pos = 0; id < reference.size(); pos += reference[id++].size() + 1) {
+            auto first = index.to_sequence_position(pos);
+            auto last = index.to_sequence_position(pos + reference[id].size() - 1);
+            check(first.sequence_id == id && first.offset == 0 && last.sequence_id == id
+                  && last.offset == reference[id].size() - 1,
+                  "flat_fm_index::to_sequence_position of sequence " + std::to_string(id) + where);
+        }
+
+        for (size_t q = 0; q < 20; ++q) {
+            size_t errors = uniform(0, 2);
+            auto query = random_query(reference, uniform(0, errors + 1));
+            auto expected = scan(reference, query, errors);
+            // with reverse complements, the query is found on them where its reverse complement is on the sequences
+            sequence reverse_query;
+            reverse_complement(query, reverse_query);
+            auto expected_reverse = reverse ? scan(reference, reverse_query, errors) : decltype(expected){};
+            std::vector<std::pair<uint64_t, uint64_t>> found, found_reverse;
+            index.search(query, errors, [&](uint64_t sp, uint64_t ep, size_t) {
+                for (uint64_t i = sp; i < ep; ++i) {
+                    auto position = index.to_sequence_position(index.locate(i));
+                    if (position.sequence_id < index.sequence_count()) {
+                        found.emplace_back(position.sequence_id, position.offset);
+                        continue;
+                    }
+                    auto [id, offset] = index.forward_position(position, query.size());
+                    found_reverse.emplace_back(id, offset);
+                }
+            });
+            std::sort(found.begin(), found.end());
+            std::sort(found_reverse.begin(), found_reverse.end());
+            check(found == expected, "flat_fm_index::search of a " + describe(query, errors) + ": "
+                                     + std::to_string(found.size()) + " instead of " + std::to_string(expected.size())
+                                     + " hits" + where);
+            check(found_reverse == expected_reverse, "flat_fm_index::search of a " + describe(query, errors) + ": "
+                                                     + std::to_string(found_reverse.size()) + " instead of "
+                                                     + std::to_string(expected_reverse.size()) + " reverse strand hits" + where);
+            check(index.count(query, errors) == expected.size() + expected_reverse.size(),
+                  "flat_fm_index::count of a " + describe(query, errors) + where);
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+// suffix sorting in buckets
+
+// a reference as random_reference, some sequences with long homopolymers, microsatellites or tandem repeats of a
+// period too long to be skipped while comparing suffixes
+std::vector<sequence> repetitive_reference() {
+    auto reference = random_reference();
+    for (auto& s : reference) {
+        if (uniform(0, 1) == 0 || s.size() < 2) continue;
+        size_t begin = uniform(0, s.size() - 1);
+        size_t end = std::min(s.size(), begin + uniform(64, 1500));
+        size_t period = uniform(0, 2) == 0 ? uniform(1, 6) : uniform(7, 40);
+        for (size_t i = begin + period; i < end; ++i) s[i] = s[i - period];
+    }
+    return reference;
+}
+
+template <typename sa_value_t>
+void test_bucketed_suffix_sort() {
+    for (size_t trial = 0; trial < 300; ++trial) {
+        auto reference = repetitive_reference();
+        flat_fm_text text;
+        for (auto const& s : reference) text.append(s);
+        auto expected = suffix_sort<sa_value_t>(text.symbols);
+
+        // from a workspace holding only the bucket table of one symbol and a few positions, which sorts large buckets
+        // in several passes, up to one holding the whole suffix array
+        uint64_t const n = text.symbols.size();
+        uint64_t const table_bytes = 3 * (flat_fm_sigma + 1) * sizeof(uint64_t);
+        uint64_t workspace = table_bytes + sizeof(sa_value_t) * (uniform(0, 1) == 0 ? uniform(1, 16) : uniform(1, n));
+        if (uniform(0, 4) == 0) workspace = uniform(table_bytes, 4 << 20);
+        size_t threads = uniform(1, 4);
+        std::string where = " with a workspace of " + std::to_string(workspace) + " bytes and "
+                          + std::to_string(threads) + " threads in trial " + std::to_string(trial);
+
+        std::vector<sa_value_t> sorted;
+        try {
+            bucketed_suffix_sort<sa_value_t>(text.symbols, flat_fm_sigma, workspace, threads,
+                                             [&](sa_value_t const* begin, sa_value_t const* end) {
+                sorted.insert(sorted.end(), begin, end);
+            });
+        } catch (std::runtime_error const&) {
+            check(workspace < table_bytes + sizeof(sa_value_t), "bucketed_suffix_sort threw" + where);
+            continue;
+        }
+        check(sorted == expected, "bucketed_suffix_sort differs from divsufsort" + where);
+    }
+
+    // a sort workspace below the suffix array sorts in buckets and writes the same index
+    auto path = std::filesystem::temp_directory_path() / ("index_test_" + std::to_string(rng()) + ".flat");
+    for (size_t trial = 0; trial < 20; ++trial) {
+        flat_fm_text text;
+        for (auto const& s : repetitive_reference()) text.append(s);
+        build_flat_fm_index(text, path, 16);
+        std::vector<char> expected = read_file(path);
+        uint64_t const n = text.symbols.size();
+        build_flat_fm_index(text, path, 16, uniform(1024, std::max<uint64_t>(1024, 4 * n - 1)), uniform(1, 4));
+        check(read_file(path) == expected, "build_flat_fm_index with a sort workspace differs in trial "
+                                           + std::to_string(trial));
+    }
+    std::filesystem::remove(path);
+}
+
+// suffix array index and its binary searches
+
+// -1 if the suffix of reference[id] at pos is smaller than query and does not start with it, 0 if it starts
+// with query, 1 if it is larger
+int compare_suffix(std::vector<sequence> const& reference, size_t id, size_t pos, sequence const& query) {
+    auto const& s = reference[id];
+    for (size_t j = 0; j < query.size(); ++j) {
+        if (pos + j == s.size()) return -1;
+        if (s[pos + j] != query[j]) return seqan3::to_rank(s[pos + j]) < seqan3::to_rank(query[j]) ? -1 : 1;
+    }
+    return 0;
+}
+
+template <typename sa_value_t>
+void test_suffix_array_index() {
+    auto path = std::filesystem::temp_directory_path() / ("index_test_" + std::to_string(rng()) + ".sa");
+    for (size_t trial = 0; trial < 300; ++trial) {
+        auto reference = random_reference();
+        packed_reference packed;
+        std::vector<uint64_t> starts;
+        std::vector<std::pair<uint64_t, uint64_t>> sequence_of; // (id, offset) of every reference position
+        for (size_t id = 0; id < reference.size(); ++id) {
+            starts.push_back(packed.size());
+            packed.append(reference[id]);
+            for (size_t pos = 0; pos < reference[id].size(); ++pos) sequence_of.emplace_back(id, pos);
+        }
+        starts.push_back(packed.size());
+        save_suffix_array_index(path, packed.view(), starts,
+                                build_suffix_array<sa_value_t>(packed.view(), {starts.data(), reference.size()}));
+        suffix_array_index index{path};
+        auto text = index.text();
+        auto boundaries = index.boundaries();
+        auto const* suffixarray = index.template suffix_array<sa_value_t>();
+        std::string where = " with " + std::to_string(sizeof(sa_value_t)) + " byte entries in trial "
+                          + std::to_string(trial);
+
+        check(text.size() == sequence_of.size() && index.sequence_count() == reference.size(),
+              "suffix_array_index of " + std::to_string(sequence_of.size()) + " bases" + where);
+        std::vector<uint64_t> sorted(suffixarray, suffixarray + text.size());
+        std::sort(sorted.begin(), sorted.end());
+        bool permutation = true;
+        for (uint64_t i = 0; i < sorted.size(); ++i) permutation &= sorted[i] == i;
+        check(permutation, "build_suffix_array is no permutation of the reference positions" + where);
+        if (!permutation) continue;
+
+        for (size_t q = 0; q < 30; ++q) {
+            // queries that exist, that span two sequences, that are mutated or that repeat a sequence
+            auto query = random_query(reference, uniform(0, 1));
+            uint64_t smaller = 0, not_larger = 0;
+            std::vector<std::pair<uint64_t, uint64_t>> expected;
+            for (auto [id, pos] : sequence_of) {
+                int c = compare_suffix(reference, id, pos, query);
+                smaller += c < 0;
+                not_larger += c <= 0;
+                if (c == 0) expected.emplace_back(id, pos);
+            }
+            uint64_t lower = sa_lower_bound(text, boundaries, suffixarray, 0, text.size(), query);
+            uint64_t upper = sa_upper_bound(text, boundaries, suffixarray, lower, text.size(), query);
+            check(lower == smaller && upper == not_larger,
+                  "sa_lower_bound and sa_upper_bound of a " + describe(query, 0) + ": [" + std::to_string(lower) + ", "
+                  + std::to_string(upper) + ") instead of [" + std::to_string(smaller) + ", "
+                  + std::to_string(not_larger) + ")" + where);
+
+            auto [first, last] = sa_equal_range(text, boundaries, suffixarray, query);
+            std::vector<std::pair<uint64_t, uint64_t>> found;
+            for (uint64_t i = first; i < last; ++i) {
+                auto [id, offset] = boundaries.to_sequence_position(suffixarray[i]);
+                found.emplace_back(id, offset);
+            }
+            std::sort(found.begin(), found.end());
+            check(found == expected, "sa_equal_range of a " + describe(query, 0) + ": " + std::to_string(found.size())
+                                     + " instead of " + std::to_string(expected.size()) + " hits" + where);
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+// Aho-Corasick matcher
+
+void test_aho_corasick() {
+    // one automaton for all trials, so clear and build run on reused buffers
+    aho_corasick automaton;
+    for (size_t trial = 0; trial < 500; ++trial) {
+        auto text = random_sequence(uniform(1, 2000));
+        // patterns that overlap: substrings of each other, duplicates, N runs and single bases
+        std::vector<sequence> patterns;
+        for (size_t p = uniform(1, 60); p > 0; --p) {
+            if (!patterns.empty() && uniform(0, 3) == 0) {
+                auto const& other = patterns[uniform(0, patterns.size() - 1)];
+                size_t length = uniform(1, other.size());
+                size_t begin = uniform(0, other.size() - length);
+                patterns.emplace_back(other.begin() + begin, other.begin() + begin + length);
+            } else {
+                patterns.push_back(random_query({text}, uniform(0, 4) == 0));
+            }
+        }
+        automaton.clear();
+        for (size_t p = 0; p < patterns.size(); ++p) {
+            check(automaton.add(patterns[p]) == p, "aho_corasick::add returns the pattern ids in order");
+        }
+        automaton.build();
+
+        size_t wrong_counts = 0, wrong_matches = 0;
+        uint32_t state = 0;
+        std::vector<uint32_t> expected, found;
+        for (size_t i = 0; i < text.size(); ++i) {
+            state = automaton.step(state, seqan3::to_rank(text[i]));
+            expected.clear();
+            for (uint32_t p = 0; p < patterns.size(); ++p) {
+                size_t m = patterns[p].size();
+                if (m <= i + 1 && mismatches(text, i + 1 - m, patterns[p]) == 0) expected.push_back(p);
+            }
+            found.clear();
+            automaton.for_each_match(state, [&](uint32_t p) {
+                found.push_back(p);
+                wrong_matches += automaton.pattern_length(p) != patterns[p].size();
+            });
+            std::sort(found.begin(), found.end());
+            wrong_counts += automaton.match_count(state) != expected.size();
+            wrong_matches += found != expected;
+        }
+        check(wrong_counts == 0 && wrong_matches == 0,
+              "aho_corasick with " + std::to_string(patterns.size()) + " patterns over " + std::to_string(text.size())
+              + " bases: " + std::to_string(wrong_counts) + " wrong match counts, " + std::to_string(wrong_matches)
+              + " wrong matches in trial " + std::to_string(trial));
+    }
+}
+
+// search schemes
+
+// bidirectional cursor over one text for search_with_scheme, it keeps the occurrences of the matched string
+class brute_force_cursor {
+    sequence const* text_ = nullptr;
+    std::vector<uint64_t> positions_;
+    uint64_t length_ = 0;
+
+public:
+    explicit brute_force_cursor(sequence const& text) : text_{&text}, positions_(text.size() + 1) {
+        for (uint64_t i = 0; i <= text.size(); ++i) positions_[i] = i;
+    }
+
+    bool extend_right(seqan3::dna5 c) {
+        std::erase_if(positions_, [&](uint64_t p) { return p + length_ >= text_->size() || (*text_)[p + length_] != c; });
+        ++length_;
+        return !positions_.empty();
+    }
+
+    bool extend_left(seqan3::dna5 c) {
+        std::erase_if(positions_, [&](uint64_t p) { return p == 0 || (*text_)[p - 1] != c; });
+        for (auto& p : positions_) --p;
+        ++length_;
+        return !positions_.empty();
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> locate() const {
+        std::vector<std::pair<uint64_t, uint64_t>> hits;
+        for (auto p : positions_) hits.emplace_back(0, p);
+        return hits;
+    }
+};
+
+struct brute_force_index {
+    sequence text;
+
+    brute_force_cursor cursor() const { return brute_force_cursor{text}; }
+};
+
+// number of distributions of up to k errors over the pieces that several searches of scheme admit
+size_t admitted_twice(search_scheme const& scheme, size_t k) {
+    size_t p = scheme.front().pi.size();
+    size_t twice = 0;
+    std::vector<size_t> errors(p, 0);
+    while (true) {
+        size_t total = std::accumulate(errors.begin(), errors.end(), size_t{0});
+        if (total <= k) {
+            size_t admitted = std::count_if(scheme.begin(), scheme.end(), [&](scheme_search const& s) {
+                size_t sum = 0;
+                for (size_t j = 0; j < p; ++j) {
+                    sum += errors[s.pi[j]];
+                    if (sum < s.l[j] || sum > s.u[j]) return false;
+                }
+                return true;
+            });
+            twice += admitted > 1;
+        }
+        // next distribution, every piece counts from 0 to k
+        size_t j = 0;
+        while (j < p && errors[j] == k) errors[j++] = 0;
+        if (j == p) return twice;
+        ++errors[j];
+    }
+}
+
+void test_search_schemes() {
+    for (std::string name : {"optimum", "pigeon", "kucherov", "01*0"}) {
+        for (size_t k = 0; k <= 4; ++k) {
+            if (name == "kucherov" && k > 2) continue;
+            auto scheme = make_search_scheme(name, k);
+            std::string where = name + " search scheme for " + std::to_string(k) + " errors";
+            try {
+                check_search_scheme(scheme, k);
+                check(true, where);
+            } catch (std::invalid_argument const& e) {
+                check(false, where + ": " + e.what());
+                continue;
+            }
+            if (name == "optimum") {
+                check(admitted_twice(scheme, k) == 0, where + " admits error distributions twice");
+            }
+
+            for (size_t trial = 0; trial < 100; ++trial) {
+                brute_force_index index{random_sequence(uniform(1, 400))};
+                auto query = random_query({index.text}, uniform(0, k + 1));
+                size_t pieces = scheme.front().pi.size();
+                while (query.size() < pieces) query.push_back(base(uniform(0, 4)));
+
+                std::vector<std::tuple<size_t, size_t, size_t>> expected;
+                for (size_t pos = 0; pos + query.size() <= index.text.size(); ++pos) {
+                    size_t errors = mismatches(index.text, pos, query);
+                    if (errors <= k) expected.emplace_back(0, pos, errors);
+                }
+                auto found = locate_with_scheme(index, query, scheme);
+                check(found == expected, "locate_with_scheme with the " + where + " of a " + describe(query, k) + ": "
+                                         + std::to_string(found.size()) + " instead of "
+                                         + std::to_string(expected.size()) + " hits");
+
+                if (name != "optimum") continue;
+                size_t reported = 0;
+                search_with_scheme(index, query, scheme, [&](auto const& cursor, size_t) {
+                    reported += cursor.locate().size();
+                });
+                check(reported == expected.size(), "search_with_scheme with the " + where + " reports "
+                                                   + std::to_string(reported) + " instead of "
+                                                   + std::to_string(expected.size()) + " hits");
+            }
+        }
+    }
+
+    // 01*0 schemes are made for any number of errors up to the limit, every named scheme rejects more
+    for (size_t k = 5; k <= max_search_scheme_errors; ++k) {
+        try {
+            check_search_scheme(seeds_01_0_search_scheme(k), k);
+            check(true, "01*0 search scheme for " + std::to_string(k) + " errors");
+        } catch (std::invalid_argument const& e) {
+            check(false, "01*0 search scheme for " + std::to_string(k) + " errors: " + e.what());
+        }
+    }
+    for (std::string name : {"optimum", "pigeon", "kucherov", "01*0", "1/0/0"}) {
+        for (size_t k : {max_search_scheme_errors + 1, size_t{254}, size_t{255}}) {
+            try {
+                make_search_scheme(name, k);
+                check(false, "make_search_scheme accepts " + std::to_string(k) + " errors for " + name);
+            } catch (std::invalid_argument const&) {
+                check(true, "make_search_scheme rejects " + std::to_string(k) + " errors for " + name);
+            }
+        }
+    }
+}
+
+// pigeon engine
+
+// collects the hits of a search as (read, strand, sequence id, position, errors)
+class collected_hits : public hit_sink {
+public:
+    std::vector<std::tuple<std::string, char, uint64_t, uint64_t, size_t>> hits;
+
+    void add(std::string_view read_id, std::vector<seqan3::dna5> const&, hit const& h) override {
+        hits.emplace_back(std::string{read_id}, h.strand, h.sequence_id, h.position, h.errors);
+    }
+};
+
+// a window of one of the sequences of at least min_length bases with up to `edits` random substitutions and, with
+// indels, insertions and deletions
+sequence random_read(std::vector<sequence> const& reference, size_t min_length, size_t edits, bool indels) {
+    auto const& s = reference[uniform(0, reference.size() - 1)];
+    size_t m = std::min(s.size(), uniform(0, 3) == 0 ? uniform(min_length, min_length + 2) : uniform(min_length, 40));
+    size_t begin = uniform(0, s.size() - m);
+    sequence read(s.begin() + begin, s.begin() + begin + m);
+    for (size_t e = 0; e < edits; ++e) {
+        size_t kind = indels ? uniform(0, 2) : 0;
+        if (kind == 0 && !read.empty()) read[uniform(0, read.size() - 1)] = base(uniform(0, 4));
+        if (kind == 1) read.insert(read.begin() + uniform(0, read.size()), base(uniform(0, 4)));
+        if (kind == 2 && !read.empty()) read.erase(read.begin() + uniform(0, read.size() - 1));
+    }
+    while (read.size() < min_length) read.push_back(base(uniform(0, 4)));
+    return read;
+}
+
+// one substitution in every part of the k + 1 the pigeon engine splits the read into but one, so only that part
+// matches exactly and every other seed is a dead end
+void spread_substitutions(sequence& read, size_t k) {
+    size_t const m = read.size();
+    size_t const parts = k + 1;
+    auto part_begin = [&](size_t part) { return part * (m / parts) + std::min(part, m % parts); };
+    size_t exact = uniform(0, k);
+    for (size_t part = 0; part < parts; ++part) {
+        if (part == exact) continue;
+        auto& c = read[uniform(part_begin(part), part_begin(part + 1) - 1)];
+        c = base((seqan3::to_rank(c) + uniform(1, 4)) % 5);
+    }
+}
+
+// fewest edits of an alignment of the whole query that begins at position b of s, for every b; computed by aligning
+// the reversed query against the reversed sequence with a free start, so the end of the alignment in s is free
+std::vector<size_t> edit_distances_from(sequence const& s, sequence const& query) {
+    size_t const m = query.size();
+    size_t const n = s.size();
+    std::vector<size_t> distances(n + 1);
+    std::vector<size_t> column(m + 1);
+    std::iota(column.begin(), column.end(), 0);
+    distances[n] = m;
+    for (size_t j = 1; j <= n; ++j) {
+        size_t diagonal = column[0];
+        column[0] = 0;
+        for (size_t i = 1; i <= m; ++i) {
+            size_t left = column[i];
+            column[i] = std::min({diagonal + (query[m - i] != s[n - j]), column[i - 1] + 1, left + 1});
+            diagonal = left;
+        }
+        distances[n - j] = column[m];
+    }
+    return distances;
+}
+
+void write_fasta(std::filesystem::path const& path, std::vector<sequence> const& reference) {
+    std::ofstream os{path};
+    for (size_t id = 0; id < reference.size(); ++id) {
+        os << ">s" << id << '\n';
+        for (auto c : reference[id]) os << "ACGNT"[seqan3::to_rank(c)];
+        os << '\n';
+    }
+}
+
+// hits of the reads with an engine made by `make`, which must count as many hits without a sink as it reports; the
+// engines report loading on the debug stream, which is silenced here
+std::vector<std::tuple<std::string, char, uint64_t, uint64_t, size_t>> engine_hits(
+        std::unique_ptr<search_engine> (*make)(search_options const&), search_options const& options,
+        query_chunk const& chunk) {
+    auto log = std::cerr.rdbuf(nullptr);
+    auto engine = make(options);
+    std::cerr.rdbuf(log);
+    auto worker = engine->make_worker();
+    collected_hits collected;
+    uint64_t count = worker->search(chunk, &collected);
+    check(count == collected.hits.size(), "the " + engine->method() + " engine counts " + std::to_string(count)
+                                          + " hits and reports " + std::to_string(collected.hits.size()));
+    check(worker->search(chunk, nullptr) == count, "the " + engine->method() + " engine counts differently without hits");
+    std::sort(collected.hits.begin(), collected.hits.end());
+    return collected.hits;
+}
+
+std::vector<std::tuple<std::string, char, uint64_t, uint64_t, size_t>> pigeon_hits(search_options const& options,
+                                                                                  query_chunk const& chunk) {
+    return engine_hits(make_pigeon_engine, options, chunk);
+}
+
+// the pigeon engine with flat indexes with and without the reverse complement and seqan3 indexes, with and without
+// batched seeding, against a brute force scan, on reads from k + 1 bases, where every part is a single base, up to
+// 40: with hamming distance, every occurrence with at most k mismatches is reported once; with edit distance, every
+// reported alignment is exact about its errors, begins at a distinct position and every occurrence has one within
+// reach of its candidate window. The flat paths of the fm-index engine are compared on every strand with hamming
+// distance.
+void test_pigeon_engine() {
+    auto directory = std::filesystem::temp_directory_path();
+    auto prefix = "index_test_" + std::to_string(rng());
+    auto flat_path = directory / (prefix + ".flat");
+    auto reverse_path = directory / (prefix + ".reverse.flat");
+    auto seqan3_path = directory / (prefix + ".index");
+    auto reference_path = directory / (prefix + ".fasta");
+    using hits_t = std::vector<std::tuple<std::string, char, uint64_t, uint64_t, size_t>>;
+    for (size_t trial = 0; trial < 80; ++trial) {
+        auto reference = random_reference();
+        flat_fm_text text;
+        for (auto const& s : reference) text.append(s);
+        build_flat_fm_index(text, flat_path, uniform(1, 16));
+        text.append_reverse_complements();
+        build_flat_fm_index(text, reverse_path, uniform(1, 16));
+        write_fasta(reference_path, reference);
+        {
+            seqan3::fm_index index{reference};
+            std::ofstream os{seqan3_path, std::ios::binary};
+            cereal::BinaryOutputArchive oarchive{os};
+            oarchive(index);
+        }
+
+        size_t const k = uniform(0, 3);
+        bool const indels = trial % 2 == 1;
+        query_chunk chunk{0, 0, {}, {}};
+        for (size_t q = 0; q < 12; ++q) {
+            chunk.queries.push_back(random_read(reference, k + 1, uniform(0, k + 1), indels));
+            if (!indels && uniform(0, 1) == 0) {
+                chunk.queries.back() = random_read(reference, k + 1, 0, false);
+                spread_substitutions(chunk.queries.back(), k);
+            }
+            chunk.ids.push_back("r" + std::to_string(q));
+        }
+        std::string where = " with " + std::to_string(k) + (indels ? " edits" : " mismatches") + " in trial "
+                          + std::to_string(trial);
+
+        search_options options;
+        options.errors = k;
+        options.indels = indels;
+        options.strand = "both";
+        options.index_path = flat_path;
+        auto found = pigeon_hits(options, chunk);
+        options.batched_seeding = 1;
+        check(pigeon_hits(options, chunk) == found, "batched seeding on the flat index differs" + where);
+        options.index_path = seqan3_path;
+        options.reference_file = reference_path;
+        check(pigeon_hits(options, chunk) == found, "batched seeding on the seqan3 index differs" + where);
+        options.batched_seeding = 0;
+        check(pigeon_hits(options, chunk) == found, "the seqan3 index differs" + where);
+        // the reverse strand is seeded with the mirrored split of the reverse complement, so with edit distance the
+        // candidate windows, and with them the alignments found, may differ
+        options.index_path = reverse_path;
+        std::vector<std::pair<std::string, hits_t>> results{{"", found}};
+        results.emplace_back(" on the reverse complement index", pigeon_hits(options, chunk));
+        options.batched_seeding = 1;
+        results.emplace_back(" with batched seeding on the reverse complement index", pigeon_hits(options, chunk));
+        check(results[2].second == results[1].second, "batched seeding on the reverse complement index differs" + where);
+
+        hits_t expected;
+        std::vector<size_t> unsound(results.size()), missed(results.size());
+        for (size_t q = 0; q < chunk.queries.size(); ++q) {
+            for (char strand : {'+', '-'}) {
+                sequence read = chunk.queries[q];
+                if (strand == '-') reverse_complement(chunk.queries[q], read);
+                for (uint64_t id = 0; id < reference.size(); ++id) {
+                    auto const& s = reference[id];
+                    if (!indels) {
+                        for (uint64_t pos = 0; pos + read.size() <= s.size(); ++pos) {
+                            size_t errors = mismatches(s, pos, read);
+                            if (errors <= k) expected.emplace_back(chunk.ids[q], strand, id, pos, errors);
+                        }
+                        continue;
+                    }
+                    auto distances = edit_distances_from(s, read);
+                    for (size_t r = 0; r < results.size(); ++r) {
+                        auto const& hits = results[r].second;
+                        auto first = std::lower_bound(hits.begin(), hits.end(),
+                                                      std::make_tuple(chunk.ids[q], strand, id, uint64_t{0}, size_t{0}));
+                        auto last = std::lower_bound(hits.begin(), hits.end(),
+                                                     std::make_tuple(chunk.ids[q], strand, id + 1, uint64_t{0}, size_t{0}));
+                        for (auto h = first; h != last; ++h) {
+                            unsound[r] += std::get<3>(*h) >= s.size() || distances[std::get<3>(*h)] != std::get<4>(*h);
+                        }
+                        // the candidate of an occurrence at b starts within k of b, and the best alignment in its
+                        // window, which reaches k bases past the query on both sides, has at most the errors of the
+                        // occurrence
+                        for (uint64_t b = 0; b < s.size(); ++b) {
+                            if (distances[b] > k) continue;
+                            missed[r] += std::none_of(first, last, [&](auto const& h) {
+                                uint64_t begin = std::get<3>(h);
+                                return begin + 2 * k >= b && begin <= b + 3 * k && std::get<4>(h) <= distances[b];
+                            });
+                        }
+                    }
+                }
+            }
+        }
+        if (!indels) {
+            std::sort(expected.begin(), expected.end());
+            for (auto const& [on, hits] : results) {
+                check(hits == expected, "the pigeon engine finds " + std::to_string(hits.size()) + " instead of "
+                                        + std::to_string(expected.size()) + " hits" + on + where);
+            }
+
+            // the fm-index engine searches the read and its reverse complement, or the read once on the reverse
+            // complement index
+            options = search_options{};
+            options.errors = k;
+            for (std::string strand : {"forward", "reverse", "both"}) {
+                hits_t expected_on_strand;
+                std::copy_if(expected.begin(), expected.end(), std::back_inserter(expected_on_strand), [&](auto const& h) {
+                    return strands(parse_strand_mode(strand)).find(std::get<1>(h)) != std::string_view::npos;
+                });
+                options.strand = strand;
+                for (auto const& path : {flat_path, reverse_path}) {
+                    options.index_path = path;
+                    auto hits = engine_hits(make_fm_index_engine, options, chunk);
+                    check(hits == expected_on_strand, "the fm-index engine finds " + std::to_string(hits.size())
+                                                      + " instead of " + std::to_string(expected_on_strand.size())
+                                                      + " hits on strand " + strand
+                                                      + (path == reverse_path ? " of the reverse complement index" : "")
+                                                      + where);
+                }
+            }
+            continue;
+        }
+        for (size_t r = 0; r < results.size(); ++r) {
+            auto const& [on, hits] = results[r];
+            check(std::adjacent_find(hits.begin(), hits.end(), [](auto const& x, auto const& y) {
+                      return std::get<0>(x) == std::get<0>(y) && std::get<1>(x) == std::get<1>(y)
+                             && std::get<2>(x) == std::get<2>(y) && std::get<3>(x) == std::get<3>(y);
+                  }) == hits.end(), "the pigeon engine reports an alignment begin twice" + on + where);
+            check(unsound[r] == 0, "the pigeon engine reports " + std::to_string(unsound[r]) + " alignments whose "
+                                   "errors differ from the best alignment beginning there" + on + where);
+            check(missed[r] == 0, "the pigeon engine misses " + std::to_string(missed[r]) + " occurrences" + on + where);
+        }
+    }
+
+    // a query of k bases can not be split into k + 1 parts
+    search_options options;
+    options.errors = 2;
+    options.index_path = flat_path;
+    query_chunk chunk{0, 0, {sequence(2, base(0))}, {"short"}};
+    try {
+        pigeon_hits(options, chunk);
+        check(false, "the pigeon engine searches a query shorter than its number of parts");
+    } catch (std::invalid_argument const&) {
+        check(true, "the pigeon engine rejects a query shorter than its number of parts");
+    }
+    std::filesystem::remove(flat_path);
+    std::filesystem::remove(reverse_path);
+    std::filesystem::remove(seqan3_path);
+    std::filesystem::remove(reference_path);
+}
+
+} // namespace
+
+int main() {
+    test_flat_fm_index();
+    test_bucketed_suffix_sort<saidx_t>();
+    test_bucketed_suffix_sort<saidx64_t>();
+    test_suffix_array_index<saidx_t>();
+    test_suffix_array_index<saidx64_t>();
+    test_aho_corasick();
+    test_search_schemes();
+    test_pigeon_engine();
+    std::cout << checks << " checks, " << failures << " failed\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+#include "hamming_kernel.hpp"
+#include "myers_verifier.hpp"
+#include "packed_reference.hpp"
+#include "rank_filter.hpp"
+
+// Compares the SIMD and bit-parallel kernels against plain scalar references on random inputs.
+// Texts get N runs around 32 base word borders and the 256 base chunks of the hamming verifier, queries are
+// mutated copies of text windows with lengths around 32, 64 and 256. Kernels the cpu does not support are
+// skipped. Exits with EXIT_FAILURE after the first few mismatches are printed.
+
+namespace {
+
+std::mt19937_64 rng{20240617};
+size_t checks = 0;
+size_t failures = 0;
+
+void check(bool ok, std::string const& what) {
+    ++checks;
+    if (ok) return;
+    if (++failures <= 20) std::cerr << "FAILED: " << what << '\n';
+}
+
+size_t uniform(size_t lo, size_t hi) {
+    return std::uniform_int_distribution<size_t>{lo, hi}(rng);
+}
+
+seqan3::dna5 random_base() {
+    return seqan3::assign_rank_to(std::array<uint8_t, 4>{0, 1, 2, 4}[uniform(0, 3)], seqan3::dna5{});
+}
+
+// random bases with N runs that start, end or span the borders of 32 and 256 base words
+std::vector<seqan3::dna5> random_text(size_t length) {
+    std::vector<seqan3::dna5> text(length);
+    for (auto& c : text) c = random_base();
+    auto n = seqan3::assign_rank_to(dna5_rank_n, seqan3::dna5{});
+    for (size_t border = 32; border < length; border += 32) {
+        if (uniform(0, 3) != 0) continue;
+        size_t before = uniform(0, border % 256 == 0 ? 40 : 3);
+        size_t after = uniform(0, 3) == 0 ? uniform(30, 100) : uniform(0, 2);
+        for (size_t i = border - std::min(before, border); i < std::min(length, border + after); ++i) text[i] = n;
+    }
+    // single Ns anywhere
+    for (size_t i = 0; i < length / 50; ++i) text[uniform(0, length - 1)] = n;
+    return text;
+}
+
+// a window of text with `edits` random substitutions, insertions or deletions, indels only if allowed
+std::vector<seqan3::dna5> mutated(std::vector<seqan3::dna5> const& text, size_t begin, size_t length, size_t edits,
+                                  bool indels) {
+    std::vector<seqan3::dna5> query(text.begin() + begin, text.begin() + begin + length);
+    for (size_t e = 0; e < edits && !query.empty(); ++e) {
+        size_t i = uniform(0, query.size() - 1);
+        size_t kind = indels ? uniform(0, 2) : 0;
+        if (kind == 0) {
+            query[i] = uniform(0, 9) == 0 ? seqan3::assign_rank_to(dna5_rank_n, seqan3::dna5{}) : random_base();
+        } else if (kind == 1) {
+            query.insert(query.begin() + i, random_base());
+        } else if (query.size() > 1) {
+            query.erase(query.begin() + i);
+        }
+    }
+    return query;
+}
+
+// query lengths around the word and block sizes of the kernels
+size_t random_query_length() {
+    static constexpr size_t lengths[] = {1, 31, 32, 33, 63, 64, 65, 100, 127, 128, 129, 255, 256, 257, 300};
+    return uniform(0, 4) == 0 ? uniform(1, 320) : lengths[uniform(0, std::size(lengths) - 1)];
+}
+
+// hamming kernels
+
+size_t scalar_mismatches(packed_reference_view const& text, uint64_t pos, std::vector<seqan3::dna5> const& query) {
+    size_t count = 0;
+    for (size_t j = 0; j < query.size(); ++j) {
+        count += text.rank(pos + j) != seqan3::to_rank(query[j]);
+    }
+    return count;
+}
+
+// mismatching bases of code and N lane words, one base at a time
+size_t scalar_hamming_words(uint64_t const* query_codes, uint64_t const* query_ns,
+                            uint64_t const* text_codes, uint64_t const* text_ns, size_t words) {
+    size_t count = 0;
+    for (size_t w = 0; w < words; ++w) {
+        for (size_t j = 0; j < 32; ++j) {
+            count += ((query_codes[w] >> (2 * j)) & 3) != ((text_codes[w] >> (2 * j)) & 3)
+                     || ((query_ns[w] >> (2 * j)) & 1) != ((text_ns[w] >> (2 * j)) & 1);
+        }
+    }
+    return count;
+}
+
+void test_hamming_words() {
+    std::vector<std::pair<char const*, hamming_words_fn>> kernels{{"scalar", hamming_words_scalar}};
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) kernels.emplace_back("avx2", hamming_words_avx2);
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq")) {
+        kernels.emplace_back("avx512", hamming_words_avx512);
+    }
+#endif
+    for (auto [name, kernel] : kernels) std::cout << "hamming kernel " << name << '\n';
+    for (size_t trial = 0; trial < 20000; ++trial) {
+        size_t words = uniform(0, 20);
+        std::vector<uint64_t> qc(words), qn(words), tc(words), tn(words);
+        for (size_t w = 0; w < words; ++w) {
+            qc[w] = rng();
+            tc[w] = uniform(0, 1) ? rng() : qc[w] ^ (uint64_t{1} << uniform(0, 63));
+            // N lanes only use the low bit of every base
+            qn[w] = uniform(0, 3) == 0 ? rng() & hamming_low_lanes : 0;
+            tn[w] = uniform(0, 3) == 0 ? rng() & hamming_low_lanes : 0;
+        }
+        size_t expected = scalar_hamming_words(qc.data(), qn.data(), tc.data(), tn.data(), words);
+        for (auto [name, kernel] : kernels) {
+            size_t found = kernel(qc.data(), qn.data(), tc.data(), tn.data(), words);
+            check(found == expected, std::string{"hamming_words_"} + name + " over " + std::to_string(words) + " words: "
+                                     + std::to_string(found) + " instead of " + std::to_string(expected));
+        }
+    }
+}
+
+void test_hamming_verifier() {
+    hamming_verifier verifier;
+    for (size_t trial = 0; trial < 10000; ++trial) {
+        auto bases = random_text(uniform(400, 3000));
+        packed_reference packed;
+        packed.append(bases);
+        auto text = packed.view();
+        size_t m = std::min(random_query_length(), bases.size());
+        size_t pos = uniform(0, bases.size() - m);
+        auto query = uniform(0, 4) == 0 ? random_text(m) : mutated(bases, pos, m, uniform(0, 6), false);
+        size_t limit = uniform(0, 8);
+        verifier.set_query(query);
+        size_t expected = scalar_mismatches(text, pos, query);
+        size_t found = verifier.mismatches(text, pos, limit);
+        check(expected > limit ? found > limit : found == expected,
+              "hamming_verifier with query length " + std::to_string(m) + " at " + std::to_string(pos) + ", limit "
+              + std::to_string(limit) + ": " + std::to_string(found) + " instead of " + std::to_string(expected));
+    }
+}
+
+// myers verifier
+
+// last dp row of the query against text[0, columns), text(i) returns the dna5 rank of column i; the alignment
+// starts anywhere (free) or at column 0 (anchored). row[i] is the distance of alignments ending after column i
+template <typename rank_fn_t>
+std::vector<size_t> scalar_last_row(std::vector<uint8_t> const& query, size_t columns, bool anchored,
+                                    rank_fn_t&& text) {
+    std::vector<size_t> row(columns + 1);
+    for (size_t i = 0; i <= columns; ++i) row[i] = anchored ? i : 0;
+    for (size_t j = 1; j <= query.size(); ++j) {
+        size_t diagonal = row[0];
+        row[0] = j;
+        for (size_t i = 1; i <= columns; ++i) {
+            size_t up = row[i];
+            row[i] = std::min({up + 1, row[i - 1] + 1, diagonal + (query[j - 1] != text(i - 1))});
+            diagonal = up;
+        }
+    }
+    return row;
+}
+
+void test_myers_verifier() {
+    myers_verifier verifier;
+    for (size_t trial = 0; trial < 3000; ++trial) {
+        auto bases = random_text(uniform(400, 3000));
+        packed_reference packed;
+        packed.append(bases);
+        auto text = packed.view();
+        size_t m = std::min(random_query_length(), bases.size() - 40);
+        size_t pos = uniform(20, bases.size() - m - 20);
+        auto query = uniform(0, 4) == 0 ? random_text(m) : mutated(bases, pos, m, uniform(0, 10), true);
+        // limits above 64 start with several active blocks
+        size_t limit = uniform(0, 3) == 0 ? uniform(0, std::min<size_t>(query.size(), 100)) : uniform(0, 12);
+        uint64_t begin = pos - uniform(0, 20);
+        uint64_t end = std::min<uint64_t>(bases.size(), pos + query.size() + uniform(1, 20));
+        std::vector<uint8_t> ranks(query.size());
+        for (size_t j = 0; j < query.size(); ++j) ranks[j] = seqan3::to_rank(query[j]);
+        std::string where = " with query length " + std::to_string(query.size()) + " in [" + std::to_string(begin)
+                          + ", " + std::to_string(end) + "), limit " + std::to_string(limit) + ": ";
+        verifier.set_query(query);
+
+        // leftmost end of the best alignment
+        auto row = scalar_last_row(ranks, end - begin, false,
+                                   [&](size_t i) { return seqan3::to_rank(bases[begin + i]); });
+        size_t best = std::min_element(row.begin() + 1, row.end()) - row.begin();
+        auto found = verifier.best_alignment(text, begin, end, limit);
+        check(row[best] > limit ? found.errors > limit : found.errors == row[best] && found.end == begin + best,
+              "myers_verifier::best_alignment" + where + std::to_string(found.errors) + " errors ending at "
+              + std::to_string(found.end) + " instead of " + std::to_string(row[best]) + " ending at "
+              + std::to_string(begin + best));
+
+        // leftmost end of the best alignment beginning at begin
+        auto anchored_row = scalar_last_row(ranks, end - begin, true,
+                                            [&](size_t i) { return seqan3::to_rank(bases[begin + i]); });
+        size_t anchored_best = std::min_element(anchored_row.begin() + 1, anchored_row.end()) - anchored_row.begin();
+        auto anchored = verifier.alignment_end(text, begin, end, limit);
+        check(anchored_row[anchored_best] > limit
+                  ? anchored.errors > limit
+                  : anchored.errors == anchored_row[anchored_best] && anchored.end == begin + anchored_best,
+              "myers_verifier::alignment_end" + where + std::to_string(anchored.errors) + " errors ending at "
+              + std::to_string(anchored.end) + " instead of " + std::to_string(anchored_row[anchored_best])
+              + " ending at " + std::to_string(begin + anchored_best));
+        if (row[best] > limit) continue;
+
+        // rightmost begin of the best alignment ending there, from the reversed query and text
+        uint64_t alignment_end = begin + best;
+        std::vector<uint8_t> reverse_ranks(ranks.rbegin(), ranks.rend());
+        auto reverse_row = scalar_last_row(reverse_ranks, alignment_end - begin, true,
+                                           [&](size_t i) { return seqan3::to_rank(bases[alignment_end - 1 - i]); });
+        size_t columns = std::min_element(reverse_row.begin() + 1, reverse_row.end()) - reverse_row.begin();
+        auto start = verifier.alignment_begin(text, begin, alignment_end, limit);
+        check(start.errors == reverse_row[columns] && start.end == alignment_end - columns,
+              "myers_verifier::alignment_begin" + where + std::to_string(start.errors) + " errors beginning at "
+              + std::to_string(start.end) + " instead of " + std::to_string(reverse_row[columns]) + " beginning at "
+              + std::to_string(alignment_end - columns));
+    }
+}
+
+// rank filter and the unpacking it runs on
+
+void test_ranks() {
+    std::vector<uint8_t> window;
+    for (size_t trial = 0; trial < 3000; ++trial) {
+        auto bases = random_text(uniform(1, 2000));
+        packed_reference packed;
+        packed.append(bases);
+        auto text = packed.view();
+        // windows that start and end inside of words as well as on their borders
+        uint64_t begin = std::min<uint64_t>(bases.size(), uniform(0, 1) ? uniform(0, 2000) : 32 * uniform(0, 62));
+        uint64_t end = std::min<uint64_t>(bases.size(), begin + (uniform(0, 1) ? uniform(0, 300) : 32 * uniform(0, 8)));
+        window.assign(end - begin, 0xff);
+        text.ranks(begin, end, window.data());
+        size_t wrong = 0;
+        for (uint64_t i = begin; i < end; ++i) {
+            wrong += window[i - begin] != seqan3::to_rank(bases[i]) || text.rank(i) != seqan3::to_rank(bases[i]);
+        }
+        check(wrong == 0, "packed_reference_view::ranks of [" + std::to_string(begin) + ", " + std::to_string(end)
+                          + "): " + std::to_string(wrong) + " wrong ranks");
+    }
+}
+
+void test_rank_filter() {
+    std::vector<std::pair<char const*, rank_filter_fn>> kernels{{"scalar", rank_filter_scalar},
+                                                                {"dispatched", rank_filter_kernel}};
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("sse2")) kernels.emplace_back("sse2", rank_filter_sse2);
+    if (__builtin_cpu_supports("avx2")) kernels.emplace_back("avx2", rank_filter_avx2);
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        kernels.emplace_back("avx512", rank_filter_avx512);
+    }
+#endif
+    for (auto [name, kernel] : kernels) std::cout << "rank filter " << name << '\n';
+    std::vector<uint32_t> expected, found;
+    for (size_t trial = 0; trial < 5000; ++trial) {
+        auto bases = random_text(uniform(1, 1500));
+        std::vector<uint8_t> text(bases.size());
+        for (size_t i = 0; i < bases.size(); ++i) text[i] = seqan3::to_rank(bases[i]);
+        size_t last_offset = std::min(random_query_length(), text.size()) - 1;
+        // position counts around the 16, 32 and 64 byte steps of the kernels
+        size_t positions = text.size() - last_offset;
+        if (uniform(0, 1)) positions = std::min(positions, 16 * uniform(1, 16) + uniform(0, 2) - 1);
+        uint8_t first = seqan3::to_rank(bases[uniform(0, bases.size() - 1)]);
+        uint8_t last = uniform(0, 4);
+        expected.clear();
+        for (size_t i = 0; i < positions; ++i) {
+            if (text[i] == first && text[i + last_offset] == last) expected.push_back(i);
+        }
+        for (auto [name, kernel] : kernels) {
+            found.assign(positions, 0);
+            found.resize(kernel(text.data(), positions, last_offset, first, last, found.data()));
+            check(found == expected, std::string{"rank_filter_"} + name + " over " + std::to_string(positions)
+                                     + " positions, offset " + std::to_string(last_offset) + ": "
+                                     + std::to_string(found.size()) + " instead of "
+                                     + std::to_string(expected.size()) + " candidates");
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    test_hamming_words();
+    test_hamming_verifier();
+    test_myers_verifier();
+    test_ranks();
+    test_rank_filter();
+    std::cout << checks << " checks, " << failures << " failed\n";
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+
+#include "aho_corasick.hpp"
+#include "packed_reference_file.hpp"
+#include "parallel.hpp"
+#include "rank_filter.hpp"
+#include "search_engine.hpp"
+#include "strand.hpp"
+
+namespace {
+
+// Start positions of the reference are split into chunks of a fixed size, no chunk crosses a sequence border.
+// A chunk is scanned with an overlap of the longest query - 1 into the rest of its sequence, so every
+// occurrence is found by the chunk it starts in. The chunks are spread dynamically over the scan threads,
+// long and short sequences balance because all chunks are alike.
+struct scan_chunk {
+    uint64_t sequence;
+    uint64_t begin; // first start position
+    uint64_t end;   // one past the last start position
+};
+
+inline constexpr uint64_t scan_chunk_size = 1 << 20;
+
+// calls on_hit(offset) for all occurences of query starting at ranks[0, positions)
+// positions whose first and last base match the query are picked with the widest rank_filter_kernel
+// and verified with memcmp; ranks must hold positions + query.size() - 1 bases
+template <typename on_hit_t>
+void findOccurences(uint8_t const* ranks, size_t positions, std::vector<uint8_t> const& query,
+                    std::vector<uint32_t>& candidates, on_hit_t&& on_hit) {
+    size_t const m = query.size();
+    candidates.resize(std::max(candidates.size(), positions));
+    size_t count = rank_filter_kernel(ranks, positions, m - 1, query[0], query[m - 1], candidates.data());
+    for (size_t c = 0; c < count; ++c) {
+        uint32_t offset = candidates[c];
+        if (std::memcmp(ranks + offset, query.data(), m) == 0) {
+            on_hit(offset);
+        }
+    }
+}
+
+class naive_engine : public search_engine {
+    reference_text reference_;
+    std::vector<scan_chunk> chunks_;
+    strand_mode mode_;
+    bool multi_pattern_;
+    size_t scan_threads_;
+
+    class worker : public search_worker {
+        // pattern, sequence and position of an occurrence
+        using match = std::tuple<uint32_t, uint64_t, uint64_t>;
+
+        // everything a scan thread writes to
+        struct scan_state {
+            std::vector<uint8_t> ranks;       // the chunk and its overlap unpacked to dna5 ranks
+            std::vector<uint32_t> candidates; // offsets into ranks passing the filter
+            std::vector<match> matches;
+            std::vector<uint64_t> pattern_counts; // hits of every pattern, if the caller counts per query
+            uint64_t count = 0;
+        };
+
+        naive_engine const& engine_;
+        std::vector<seqan3::dna5> reverse_query_;
+        std::vector<std::vector<uint8_t>> patterns_;      // dna5 ranks of every searched orientation
+        std::vector<std::pair<size_t, char>> pattern_of_; // query and strand of every pattern id
+        size_t max_length_ = 0;
+        aho_corasick automaton_;
+        std::vector<scan_state> states_;
+        std::vector<match> matches_;
+
+        void add_pattern(std::vector<seqan3::dna5> const& query, size_t q, char strand) {
+            if (patterns_.size() == pattern_of_.size()) patterns_.emplace_back();
+            auto& pattern = patterns_[pattern_of_.size()];
+            pattern.resize(query.size());
+            for (size_t j = 0; j < query.size(); ++j) {
+                pattern[j] = seqan3::to_rank(query[j]);
+            }
+            if (engine_.multi_pattern_) automaton_.add(query);
+            pattern_of_.emplace_back(q, strand);
+            max_length_ = std::max(max_length_, query.size());
+        }
+
+        // every query one after the other over the unpacked chunk
+        void scan_per_query(scan_chunk const& chunk, uint64_t window_end, scan_state& state, bool locate, bool per_pattern) {
+            uint64_t const sequence_begin = engine_.reference_.sequence_start(chunk.sequence);
+            for (size_t p = 0; p < pattern_of_.size(); ++p) {
+                auto const& pattern = patterns_[p];
+                if (chunk.begin + pattern.size() > window_end) continue;
+                size_t positions = std::min(chunk.end, window_end + 1 - pattern.size()) - chunk.begin;
+                findOccurences(state.ranks.data(), positions, pattern, state.candidates, [&](uint32_t offset) {
+                    state.count++;
+                    if (per_pattern) state.pattern_counts[p]++;
+                    if (locate) state.matches.emplace_back(p, chunk.sequence, chunk.begin + offset - sequence_begin);
+                });
+            }
+        }
+
+        // all queries at once through the automaton, matches that start in the overlap belong to the next chunk
+        void scan_multi_pattern(scan_chunk const& chunk, uint64_t window_end, scan_state& state, bool locate, bool per_pattern) {
+            uint64_t const sequence_begin = engine_.reference_.sequence_start(chunk.sequence);
+            uint32_t node = 0;
+            for (uint64_t i = chunk.begin; i < window_end; ++i) {
+                node = automaton_.step(node, state.ranks[i - chunk.begin]);
+                if (automaton_.match_count(node) == 0) continue;
+                if (!locate && !per_pattern && i < chunk.end) {
+                    state.count += automaton_.match_count(node);
+                    continue;
+                }
+                automaton_.for_each_match(node, [&](uint32_t p) {
+                    uint64_t start = i + 1 - automaton_.pattern_length(p);
+                    if (start >= chunk.end) return;
+                    state.count++;
+                    if (per_pattern) state.pattern_counts[p]++;
+                    if (locate) state.matches.emplace_back(p, chunk.sequence, start - sequence_begin);
+                });
+            }
+        }
+
+    public:
+        explicit worker(naive_engine const& engine) : engine_{engine}, states_(engine.scan_threads_) {}
+
+        uint64_t search(query_chunk const& chunk, hit_sink* hits, std::span<uint64_t> query_counts) override {
+            pattern_of_.clear();
+            automaton_.clear();
+            max_length_ = 0;
+            for (size_t q = 0; q < chunk.queries.size(); ++q) {
+                auto const& read = chunk.queries[q];
+                if (read.empty()) continue;
+                for (char strand : strands(engine_.mode_)) {
+                    if (strand == '-') reverse_complement(read, reverse_query_);
+                    add_pattern(strand == '+' ? read : reverse_query_, q, strand);
+                }
+            }
+            if (pattern_of_.empty()) return 0;
+            if (engine_.multi_pattern_) automaton_.build();
+
+            bool const locate = hits != nullptr;
+            bool const per_pattern = !query_counts.empty();
+            auto const& reference = engine_.reference_;
+            auto const& text = reference.view();
+            for (auto& state : states_) {
+                state.matches.clear();
+                state.count = 0;
+                if (per_pattern) state.pattern_counts.assign(pattern_of_.size(), 0);
+            }
+            parallel_for_each_index_on_thread(engine_.chunks_.size(), states_.size(), [&](size_t t, size_t c) {
+                auto const& scan = engine_.chunks_[c];
+                auto& state = states_[t];
+                uint64_t window_end = std::min(reference.sequence_start(scan.sequence + 1), scan.end + max_length_ - 1);
+                state.ranks.resize(std::max<size_t>(state.ranks.size(), window_end - scan.begin));
+                text.ranks(scan.begin, window_end, state.ranks.data());
+                if (engine_.multi_pattern_) {
+                    scan_multi_pattern(scan, window_end, state, locate, per_pattern);
+                } else {
+                    scan_per_query(scan, window_end, state, locate, per_pattern);
+                }
+            });
+
+            uint64_t count = 0;
+            for (auto const& state : states_) {
+                count += state.count;
+                for (size_t p = 0; per_pattern && p < pattern_of_.size(); ++p) {
+                    query_counts[pattern_of_[p].first] += state.pattern_counts[p];
+                }
+            }
+            if (!locate) return count;
+            // the hits of all chunks are merged per query and strand, in reference order
+            matches_.clear();
+            for (auto const& state : states_) {
+                matches_.insert(matches_.end(), state.matches.begin(), state.matches.end());
+            }
+            std::sort(matches_.begin(), matches_.end());
+            for (auto [p, sequence, position] : matches_) {
+                auto [q, strand] = pattern_of_[p];
+                hits->add(chunk.ids[q], chunk.queries[q], hit{sequence, position, strand, 0, false});
+            }
+            return count;
+        }
+    };
+
+public:
+    explicit naive_engine(search_options const& options)
+        : reference_{options.reference_file}, mode_{parse_strand_mode(options.strand)}
+        , multi_pattern_{options.multi_pattern == 1}, scan_threads_{options.scan_threads} {
+        for (uint64_t r = 0; r < reference_.sequence_count(); ++r) {
+            uint64_t end = reference_.sequence_start(r + 1);
+            for (uint64_t begin = reference_.sequence_start(r); begin < end; begin += scan_chunk_size) {
+                chunks_.push_back(scan_chunk{r, begin, std::min(end, begin + scan_chunk_size)});
+            }
+        }
+    }
+
+    std::string method() const override { return multi_pattern_ ? "Naive Search Multi-Pattern" : "Naive Search"; }
+
+    std::vector<uint64_t> sequence_lengths() const override {
+        std::vector<uint64_t> lengths;
+        for (uint64_t id = 0; id < reference_.sequence_count(); ++id) {
+            lengths.push_back(reference_.sequence_length(id));
+        }
+        return lengths;
+    }
+
+    std::unique_ptr<search_worker> make_worker() const override {
+        return std::make_unique<worker>(*this);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<search_engine> make_naive_engine(search_options const& options) {
+    if (options.errors != 0) {
+        throw std::runtime_error("the naive search only finds exact matches");
+    }
+    if (options.multi_pattern != 0 && options.multi_pattern != 1) {
+        throw std::runtime_error("multi_pattern must be either 0 or 1");
+    }
+    if (options.scan_threads == 0) {
+        throw std::runtime_error("scan_threads must be at least 1");
+    }
+    // read reference into memory, 2 bits per base
+    return std::make_unique<naive_engine>(options);
+}
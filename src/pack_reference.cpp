@@ -0,0 +1,38 @@
+#include <sstream>
+#include <filesystem>
+
+#include <seqan3/argument_parser/all.hpp>
+#include <seqan3/core/debug_stream.hpp>
+
+#include "packed_reference_file.hpp"
+
+int main(int argc, char const* const* argv) {
+    seqan3::argument_parser parser{"pack_reference", argc, argv, seqan3::update_notifications::off};
+
+    parser.info.author = "SeqAn-Team";
+    parser.info.version = "1.0.0";
+
+    auto reference_file = std::filesystem::path{};
+    parser.add_option(reference_file, '\0', "reference", "path to the reference file");
+
+    auto output_file = std::filesystem::path{};
+    parser.add_option(output_file, '\0', "output", "path to the packed reference that is written (2 bits per base, can be mmap'ed)");
+
+    try {
+         parser.parse();
+    } catch (seqan3::argument_parser_error const& ext) {
+        seqan3::debug_stream << "Parsing error. " << ext.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    seqan3::debug_stream << "Packing reference ... " << std::flush;
+    reference_text reference{reference_file};
+    std::vector<uint64_t> sequence_starts;
+    for (uint64_t id = 0; id <= reference.sequence_count(); ++id) {
+        sequence_starts.push_back(reference.sequence_start(id));
+    }
+    save_packed_reference(output_file, reference.view(), sequence_starts);
+    seqan3::debug_stream << "done\n";
+
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+#include <seqan3/core/debug_stream.hpp>
+#include <seqan3/search/fm_index/fm_index.hpp>
+#include <seqan3/search/search.hpp>
+
+#include "flat_fm_index.hpp"
+#include "hamming_kernel.hpp"
+#include "myers_verifier.hpp"
+#include "packed_reference_file.hpp"
+#include "search_engine.hpp"
+#include "strand.hpp"
+
+namespace {
+
+class pigeon_engine : public search_engine {
+    using Index = decltype(seqan3::fm_index{std::vector<std::vector<seqan3::dna5>>{}}); // Some hack
+
+    // a flat index is mmap'ed and locates hits itself, a seqan3 index needs the reference for verification
+    Index index_; // construct fm-index
+    std::optional<flat_fm_index> flat_index_;
+    std::optional<reference_text> reference_;
+    size_t max_error_total_;
+    bool indels_;
+    bool batched_seeding_;
+    strand_mode mode_;
+
+    // A worker searches batches of oriented queries (a read or its reverse complement) in three stages:
+    // the parts of all queries of a batch are searched exactly, the candidates they imply are collected, and the
+    // candidates are verified in the order of their text position. Without --batched-seeding a batch is a single
+    // read in every orientation searched, with it the batch is the whole chunk of reads. Only the flat index shares
+    // backward search steps between parts of a batch, on the seqan3 index every part is searched with a cursor of its
+    // own. If the flat index holds the reverse complement of the reference, the reverse orientation of a read is
+    // seeded with the parts of the read itself, located on the reverse complements: both orientations share all
+    // backward search steps, and --strand both costs a single backward search per part.
+    class worker : public search_worker {
+        struct oriented_query {
+            size_t q;    // read in the chunk
+            char strand;
+            std::span<seqan3::dna5 const> sequence;
+        };
+
+        // a part of an oriented query, searched exactly
+        struct piece {
+            uint32_t oriented;
+            uint32_t offset; // position of the part inside of the query
+            std::span<seqan3::dna5 const> sequence;
+            bool reverse;    // sequence is the reverse complement of the part, located on the reverse complements
+        };
+
+        // a candidate occurrence of a whole query, implied by an exact match of one of its parts
+        struct candidate {
+            int64_t start;          // text position the query would start at
+            uint32_t oriented;
+            uint64_t sequence_id;
+            int64_t sequence_begin; // text position of the sequence
+            int64_t sequence_end;
+
+            // with indels a start may lie before its sequence, so candidates of different sequences can share it
+            bool operator<(candidate const& other) const {
+                return std::tie(start, oriented, sequence_id) < std::tie(other.start, other.oriented, other.sequence_id);
+            }
+            bool operator==(candidate const& other) const {
+                return start == other.start && oriented == other.oriented && sequence_id == other.sequence_id;
+            }
+        };
+
+        // a candidate that passed verification
+        struct verified {
+            uint32_t oriented;
+            uint64_t position; // text position the alignment starts at
+            size_t errors;
+            uint64_t sequence_id;
+            int64_t sequence_begin;
+            int64_t sequence_end;
+
+            bool operator<(verified const& other) const {
+                return std::tie(oriented, position, errors) < std::tie(other.oriented, other.position, other.errors);
+            }
+        };
+
+        pigeon_engine const& engine_;
+        // the buffers below are reused for every batch, after the largest batch has been seen no batch allocates
+        std::vector<std::vector<seqan3::dna5>> reverse_queries_;
+        std::vector<oriented_query> oriented_;
+        std::vector<hamming_verifier> hamming_verifiers_;
+        std::vector<myers_verifier> edit_verifiers_;
+        std::vector<piece> pieces_;
+        std::vector<uint32_t> piece_order_;
+        std::vector<std::pair<uint64_t, uint64_t>> intervals_; // sa interval after each backward step
+        std::vector<sequence_position> located_;
+        std::vector<candidate> candidates_;
+        std::vector<verified> verified_;
+
+        void add_candidate(piece const& p, uint64_t sequence_id, int64_t sequence_begin, int64_t sequence_end, uint64_t offset) {
+            int64_t start = sequence_begin + int64_t(offset) - int64_t(p.offset);
+            // without indels, candidates must lie completely inside of the sequence the part was found in
+            int64_t length = oriented_[p.oriented].sequence.size();
+            if (!engine_.indels_ && (start < sequence_begin || start + length > sequence_end)) return;
+            candidates_.push_back(candidate{start, p.oriented, sequence_id, sequence_begin, sequence_end});
+        }
+
+        // the pieces are searched sorted by their reversed sequence, so a piece continues the backward search of
+        // its predecessor from their longest common suffix, and a repeated piece reuses its predecessor's positions
+        void seed_flat() {
+            auto const& index = *engine_.flat_index_;
+            piece_order_.resize(pieces_.size());
+            std::iota(piece_order_.begin(), piece_order_.end(), 0);
+            std::sort(piece_order_.begin(), piece_order_.end(), [&](uint32_t a, uint32_t b) {
+                auto const& x = pieces_[a].sequence;
+                auto const& y = pieces_[b].sequence;
+                return std::lexicographical_compare(x.rbegin(), x.rend(), y.rbegin(), y.rend(), [](auto c, auto d) {
+                    return seqan3::to_rank(c) < seqan3::to_rank(d);
+                });
+            });
+            located_.clear();
+            intervals_.resize(1);
+            intervals_[0] = {0, index.size()};
+            std::span<seqan3::dna5 const> previous;
+            size_t matched = 0; // backward steps of the previous piece that left a non-empty interval
+            size_t located_begin = 0;
+            for (uint32_t id : piece_order_) {
+                auto const& p = pieces_[id];
+                auto const& sequence = p.sequence;
+                size_t common = 0;
+                while (common < sequence.size() && common < previous.size()
+                       && seqan3::to_rank(sequence[sequence.size() - 1 - common]) == seqan3::to_rank(previous[previous.size() - 1 - common])) {
+                    ++common;
+                }
+                if (common != sequence.size() || common != previous.size()) {
+                    located_begin = located_.size();
+                    // if the previous piece ran empty inside of the common suffix, this one does as well
+                    if (common <= matched) {
+                        intervals_.resize(std::max(intervals_.size(), sequence.size() + 1));
+                        auto [sp, ep] = intervals_[common];
+                        size_t depth = common;
+                        for (; depth < sequence.size(); ++depth) {
+                            if (!index.backward_step(flat_fm_code(sequence[sequence.size() - 1 - depth]), sp, ep)) break;
+                            intervals_[depth + 1] = {sp, ep};
+                        }
+                        matched = depth;
+                        if (depth == sequence.size()) {
+                            for (uint64_t i = sp; i < ep; ++i) {
+                                located_.push_back(index.to_sequence_position(index.locate(i)));
+                            }
+                        }
+                    }
+                }
+                for (size_t l = located_begin; l < located_.size(); ++l) {
+                    auto position = located_[l];
+                    if ((position.sequence_id >= index.sequence_count()) != p.reverse) continue;
+                    if (p.reverse) position = index.forward_position(position, sequence.size());
+                    auto [sequence_id, offset] = position;
+                    int64_t sequence_begin = index.sequence_start(sequence_id) - sequence_id;
+                    add_candidate(p, sequence_id, sequence_begin, sequence_begin + index.sequence_length(sequence_id), offset);
+                }
+                previous = sequence;
+            }
+        }
+
+        // every piece with its own cursor on the seqan3 index; extending a cursor and walking its lazy locate
+        // view do not allocate, unlike the result vector of seqan3::search
+        void seed_seqan3() {
+            auto const& reference = *engine_.reference_;
+            for (auto const& p : pieces_) {
+                auto cursor = engine_.index_.cursor();
+                if (!cursor.extend_right(p.sequence)) continue;
+                // positions are relative to the sequence the part was found in
+                for (auto const& [sequence_id, offset] : cursor.lazy_locate()) {
+                    int64_t sequence_begin = reference.sequence_start(sequence_id);
+                    add_candidate(p, sequence_id, sequence_begin, sequence_begin + reference.sequence_length(sequence_id), offset);
+                }
+            }
+        }
+
+        uint64_t search_batch(query_chunk const& chunk, hit_sink* hits, std::span<uint64_t> query_counts) {
+            auto const text = engine_.flat_index_ ? engine_.flat_index_->text() : engine_.reference_->view();
+            int64_t const max_error_total = engine_.max_error_total_;
+            size_t const n_parts = max_error_total + 1;
+            bool const indels = engine_.indels_;
+            bool const reverse_index = engine_.flat_index_ && engine_.flat_index_->has_reverse_complement();
+
+            // a query split into n_parts parts has one exactly matching part if it has at most n_parts - 1 errors
+            pieces_.clear();
+            if (indels) {
+                edit_verifiers_.resize(std::max(edit_verifiers_.size(), oriented_.size()));
+            } else {
+                hamming_verifiers_.resize(std::max(hamming_verifiers_.size(), oriented_.size()));
+            }
+            for (uint32_t o = 0; o < oriented_.size(); ++o) {
+                auto const& query = oriented_[o].sequence;
+                if (indels) {
+                    edit_verifiers_[o].set_query(query);
+                } else {
+                    hamming_verifiers_[o].set_query(query);
+                }
+                // balanced like plan_search, the first m % n_parts parts are one character longer
+                size_t const m = query.size();
+                if (m < n_parts) {
+                    throw std::invalid_argument("query of length " + std::to_string(m) + " is shorter than the "
+                                                + std::to_string(n_parts) + " parts it is split into");
+                }
+                auto part_begin = [m, n_parts](size_t part) { return part * (m / n_parts) + std::min(part, m % n_parts); };
+                // the parts of the read are the reverse complements of a split of its reverse complement
+                bool const reverse = reverse_index && oriented_[o].strand == '-';
+                std::span<seqan3::dna5 const> const searched = reverse ? std::span<seqan3::dna5 const>{chunk.queries[oriented_[o].q]} : query;
+                for (size_t part = 0; part < n_parts; ++part) {
+                    size_t begin = part_begin(part);
+                    size_t length = part_begin(part + 1) - begin;
+                    pieces_.push_back(piece{o, uint32_t(reverse ? m - begin - length : begin), searched.subspan(begin, length), reverse});
+                }
+            }
+
+            candidates_.clear();
+            if (engine_.flat_index_) {
+                seed_flat();
+            } else {
+                seed_seqan3();
+            }
+            // parts matching at the same start are verified once, in text order
+            std::sort(candidates_.begin(), candidates_.end());
+            candidates_.erase(std::unique(candidates_.begin(), candidates_.end()), candidates_.end());
+
+            verified_.clear();
+            for (auto const& c : candidates_) {
+                if (!indels) {
+                    size_t errors = hamming_verifiers_[c.oriented].mismatches(text, c.start, max_error_total);
+                    if (errors > size_t(max_error_total)) continue;
+                    verified_.push_back(verified{c.oriented, uint64_t(c.start), errors, c.sequence_id, c.sequence_begin, c.sequence_end});
+                    continue;
+                }
+                // aligns the query within error-total edits of the candidate start, clipped to its sequence, and
+                // finds where the best alignment begins
+                auto& verifier = edit_verifiers_[c.oriented];
+                int64_t begin = std::max<int64_t>(c.sequence_begin, c.start - max_error_total);
+                int64_t end = std::min<int64_t>(c.sequence_end, c.start + oriented_[c.oriented].sequence.size() + max_error_total);
+                if (begin >= end) continue;
+                auto found = verifier.best_alignment(text, begin, end, max_error_total);
+                if (found.errors > size_t(max_error_total)) continue;
+                uint64_t start = verifier.alignment_begin(text, begin, found.end, max_error_total).end;
+                verified_.push_back(verified{c.oriented, start, found.errors, c.sequence_id, c.sequence_begin, c.sequence_end});
+            }
+
+            // hits are handed out per query; with indels, candidates at different starts can align to the same
+            // occurrence, so hits are told apart by where their alignment begins and keep their fewest errors
+            std::sort(verified_.begin(), verified_.end());
+            uint64_t count = 0;
+            for (size_t v = 0; v < verified_.size(); ++v) {
+                auto const& found = verified_[v];
+                if (v > 0 && verified_[v - 1].oriented == found.oriented && verified_[v - 1].position == found.position) continue;
+                auto const& query = oriented_[found.oriented];
+                count++;
+                if (!query_counts.empty()) query_counts[query.q]++;
+                if (!hits) continue;
+                size_t errors = found.errors;
+                if (indels) {
+                    // the best alignment beginning there may end outside of the candidate windows
+                    uint64_t end = std::min<int64_t>(found.sequence_end, found.position + query.sequence.size() + max_error_total);
+                    errors = std::min(errors, edit_verifiers_[found.oriented].alignment_end(text, found.position, end, max_error_total).errors);
+                }
+                hits->add(chunk.ids[query.q], chunk.queries[query.q],
+                          hit{found.sequence_id, found.position - found.sequence_begin, query.strand, errors, indels});
+            }
+            return count;
+        }
+
+    public:
+        explicit worker(pigeon_engine const& engine) : engine_{engine} {}
+
+        uint64_t search(query_chunk const& chunk, hit_sink* hits, std::span<uint64_t> query_counts) override {
+            bool const batched = engine_.batched_seeding_;
+            size_t const batch_size = (batched ? chunk.queries.size() : 1) * strands(engine_.mode_).size();
+            // a batch keeps the reverse complements of all its reads
+            reverse_queries_.resize(std::max(reverse_queries_.size(), batched ? chunk.queries.size() : 1));
+            oriented_.clear();
+            uint64_t total_count = 0;
+            for (size_t q = 0; q < chunk.queries.size(); ++q)
+            {
+                auto const& read = chunk.queries[q];
+                auto& reverse_query = reverse_queries_[batched ? q : 0];
+                for (char strand : strands(engine_.mode_))
+                {
+                    if (strand == '-') reverse_complement(read, reverse_query);
+                    oriented_.push_back(oriented_query{q, strand, strand == '+' ? read : reverse_query});
+                    if (oriented_.size() == batch_size) {
+                        total_count += search_batch(chunk, hits, query_counts);
+                        oriented_.clear();
+                    }
+                }
+            }
+            if (!oriented_.empty()) {
+                total_count += search_batch(chunk, hits, query_counts);
+            }
+            return total_count;
+        }
+    };
+
+public:
+    explicit pigeon_engine(search_options const& options)
+        : max_error_total_{options.errors}, indels_{options.indels == 1}, batched_seeding_{options.batched_seeding == 1}
+        , mode_{parse_strand_mode(options.strand)} {
+        if (options.indels != 0 && options.indels != 1) {
+            throw std::runtime_error("indels must be either 0 or 1");
+        }
+        if (options.batched_seeding != 0 && options.batched_seeding != 1) {
+            throw std::runtime_error("batched_seeding must be either 0 or 1");
+        }
+        // loading fm-index into memory
+        if (is_flat_fm_index(options.index_path)) {
+            seqan3::debug_stream << "Mapping flat FM-Index ... " << std::flush;
+            flat_index_.emplace(options.index_path);
+            seqan3::debug_stream << "done\n";
+        } else {
+            reference_.emplace(options.reference_file);
+
+            seqan3::debug_stream << "Loading 2FM-Index ... " << std::endl;
+            std::ifstream is{options.index_path, std::ios::binary};
+            cereal::BinaryInputArchive iarchive{is};
+            iarchive(index_);
+            seqan3::debug_stream << "done\n";
+        }
+    }
+
+    std::string method() const override { return indels_ ? "FM-Index-Pigeon-Edit" : "FM-Index-Pigeon"; }
+
+    std::vector<uint64_t> sequence_lengths() const override {
+        std::vector<uint64_t> lengths;
+        uint64_t sequence_count = flat_index_ ? flat_index_->sequence_count() : reference_->sequence_count();
+        for (uint64_t id = 0; id < sequence_count; ++id) {
+            lengths.push_back(flat_index_ ? flat_index_->sequence_length(id) : reference_->sequence_length(id));
+        }
+        return lengths;
+    }
+
+    std::unique_ptr<search_worker> make_worker() const override {
+        return std::make_unique<worker>(*this);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<search_engine> make_pigeon_engine(search_options const& options) {
+    return std::make_unique<pigeon_engine>(options);
+}
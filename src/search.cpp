@@ -0,0 +1,29 @@
+#include <iostream>
+
+#include "search_engine.hpp"
+
+// one front end for all engines, the engine is selected at runtime
+int main(int argc, char const* const* argv) {
+    seqan3::argument_parser parser{"search", argc, argv, seqan3::update_notifications::off};
+    init_parser(parser);
+
+    std::string engine_name = "fmindex";
+    parser.add_option(engine_name, '\0', "engine", "naive, suffixarray, fmindex or pigeon");
+
+    search_options options;
+    parser.add_option(options.reference_file, '\0', "reference", "path to the reference file (sequence file or packed reference)");
+    parser.add_option(options.index_path, '\0', "index", "path to the index of the engine");
+    parser.add_option(options.errors, '\0', "error-total", "number of total errors (fmindex and pigeon)");
+    parser.add_option(options.bi_fm_index, '\0', "bi-fm-index", "load a fm-index (0); load a bi-fm-index (1) (fmindex)");
+    parser.add_option(options.search_scheme, '\0', "search-scheme", "search the bi-fm-index with a search scheme (fmindex)");
+    parser.add_option(options.indels, '\0', "indels", "verify candidates with hamming distance (0) or with edit distance (1); every candidate reports its best edit alignment, alignments beginning at the same position are reported once with their fewest errors (pigeon)");
+    parser.add_option(options.batched_seeding, '\0', "batched-seeding", "search the parts of all queries of a chunk together and verify their candidates in text order (1); parts sharing a suffix share backward search steps only on a flat (mmap) index (pigeon)");
+    parser.add_option(options.multi_pattern, '\0', "multi-pattern", "match all queries of a chunk in one pass over the reference (1) (naive)");
+    parser.add_option(options.scan_threads, '\0', "scan-threads", "number of threads the reference is split across for every chunk of queries (naive)");
+    add_query_options(parser, options);
+    if (!parse_arguments(parser)) return EXIT_FAILURE;
+
+    auto engine = make_search_engine(engine_name, options);
+    print_report(std::cout, options, run_search(*engine, options));
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include <seqan3/argument_parser/all.hpp>
+#include <seqan3/core/debug_stream.hpp>
+
+#include "gzip_input.hpp"
+#include "search_protocol.hpp"
+
+// sends a query file to a running search_server and writes the hits it answers with
+int main(int argc, char const* const* argv) {
+    seqan3::argument_parser parser{"search_client", argc, argv, seqan3::update_notifications::off};
+    parser.info.author = "SeqAn-Team";
+    parser.info.version = "1.0.0";
+
+    std::filesystem::path socket_path;
+    std::filesystem::path query_file;
+    std::filesystem::path output_file;
+    search_request request;
+    request.format = "count";
+    parser.add_option(socket_path, '\0', "socket", "unix domain socket of the server");
+    parser.add_option(request.index, '\0', "index", "name of the index, as given to --serve of the server");
+    parser.add_option(query_file, '\0', "query", "path to the query file, fasta or fastq, optionally gzip compressed");
+    parser.add_option(request.format, '\0', "output-format", "count, tsv or sam");
+    parser.add_option(output_file, '\0', "output", "write the hits to this file instead of stdout");
+    try {
+         parser.parse();
+    } catch (seqan3::argument_parser_error const& ext) {
+        seqan3::debug_stream << "Parsing error. " << ext.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // the server parses the records, the client only decompresses them
+    gzip_streambuf buffer{query_file};
+    std::istream input{&buffer};
+    input.exceptions(std::ios::badbit);
+    request.queries.assign(std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{});
+    if (request.queries.size() > protocol_max_request_bytes) {
+        seqan3::debug_stream << "the queries take " << request.queries.size() << " bytes, a request may take at most "
+                             << protocol_max_request_bytes << '\n';
+        return EXIT_FAILURE;
+    }
+
+    int fd = connect_unix_socket(socket_path);
+    fd_stream stream{fd, fd};
+    auto t1 = std::chrono::high_resolution_clock::now();
+    write_request(stream, request);
+    auto response = read_response(stream);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    stream.write_all("QUIT\n");
+    ::close(fd);
+
+    if (!response.ok) {
+        seqan3::debug_stream << "search failed: " << response.body << '\n';
+        return EXIT_FAILURE;
+    }
+    if (!output_file.empty()) {
+        std::ofstream{output_file, std::ios::binary} << response.body;
+    } else {
+        std::cout << response.body;
+    }
+
+    std::cerr << ">>>>>" << std::endl;
+    std::cerr << "> Method: Server-" << request.index << std::endl;
+    std::cerr << "> Query File: " << query_file << std::endl;
+    std::cerr << "> Total Count: " << response.hits << std::endl;
+    std::cerr << "> Search duration: " << std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() << " ns\n";
+    std::cerr << "<<<<" << std::endl;
+    return 0;
+}
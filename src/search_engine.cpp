@@ -0,0 +1,112 @@
+#include <optional>
+#include <stdexcept>
+
+#include <seqan3/core/debug_stream.hpp>
+
+#include "allocation_counter.hpp"
+#include "search_engine.hpp"
+#include "strand.hpp"
+
+// overridden by src/allocation_counter.cpp in the executables that count allocations
+__attribute__((weak)) uint64_t thread_allocation_count() {
+    return 0;
+}
+
+std::unique_ptr<search_engine> make_search_engine(std::string const& name, search_options const& options) {
+    if (name == "naive") return make_naive_engine(options);
+    if (name == "suffixarray") return make_suffix_array_engine(options);
+    if (name == "fmindex") return make_fm_index_engine(options);
+    if (name == "pigeon") return make_pigeon_engine(options);
+    throw std::runtime_error("unknown engine " + name + ", expected naive, suffixarray, fmindex or pigeon");
+}
+
+std::unique_ptr<search_worker> make_search_worker(search_engine const& engine, search_options const& options) {
+    if (options.dedup != 0 && options.dedup != 1) {
+        throw std::runtime_error("dedup must be either 0 or 1");
+    }
+    if (options.dedup == 0 && options.query_cache == 0) {
+        return engine.make_worker();
+    }
+    return make_dedup_worker(engine.make_worker(), options.query_cache);
+}
+
+search_report run_search(search_engine const& engine, search_options const& options) {
+    if (options.threads == 0) {
+        throw std::runtime_error("threads must be at least 1");
+    }
+    hit_format const format = parse_hit_format(options.output_format);
+
+    bool const locate = !options.output_file.empty();
+    std::optional<hit_output> output;
+    if (locate) {
+        output.emplace(options.output_file, format);
+        output->write_header(engine.sequence_lengths());
+    }
+
+    std::vector<std::unique_ptr<search_worker>> workers;
+    std::vector<hit_formatter> formatters(options.threads, hit_formatter{format});
+    std::vector<uint64_t> thread_counts(options.threads, 0);
+    std::vector<uint64_t> thread_allocations(options.threads, 0);
+    for (size_t t = 0; t < options.threads; ++t) {
+        workers.push_back(make_search_worker(engine, options));
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    // the queries are streamed in chunks, every thread searches the chunks it takes with its own worker
+    // and formats their hits into its own buffer, which it swaps with the recycled buffer of a written chunk
+    stream_queries(options.query_file, options.query_limit, options.threads,
+                   [&](size_t thread_id, query_chunk const& chunk, std::string& chunk_output) {
+        uint64_t allocations = thread_allocation_count();
+        thread_counts[thread_id] += workers[thread_id]->search(chunk, locate ? &formatters[thread_id] : nullptr);
+        thread_allocations[thread_id] += thread_allocation_count() - allocations;
+        formatters[thread_id].swap_buffer(chunk_output);
+    }, locate ? &output->stream() : nullptr);
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    search_report report{engine.method(), 0, std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1)};
+    for (size_t t = 0; t < options.threads; ++t) {
+        report.total_count += thread_counts[t];
+        report.allocations += thread_allocations[t];
+    }
+    return report;
+}
+
+void print_report(std::ostream& os, search_options const& options, search_report const& report) {
+    os << ">>>>>" << std::endl;
+    os << "> Method: " << report.method << std::endl;
+    os << "> Query File: " << options.query_file << std::endl;
+    os << "> Query Limit: " << options.query_limit << std::endl;
+    os << "> Excepted Errors: " << static_cast<unsigned int>(options.errors) << std::endl;
+    os << "> Strand: " << options.strand << std::endl;
+    os << "> Threads: " << options.threads << std::endl;
+    os << "> Total Count: " << report.total_count << std::endl;
+    os << "> Search duration: " << report.duration.count() << " ns\n";
+    os << "> Search allocations: " << report.allocations << std::endl;
+    os << "<<<<" << std::endl;
+}
+
+void init_parser(seqan3::argument_parser& parser) {
+    parser.info.author = "SeqAn-Team";
+    parser.info.version = "1.0.0";
+}
+
+void add_query_options(seqan3::argument_parser& parser, search_options& options) {
+    parser.add_option(options.query_file, '\0', "query", "path to the query file");
+    parser.add_option(options.query_limit, '\0', "query-lim", "query limit");
+    parser.add_option(options.strand, '\0', "strand", "search the queries (forward), their reverse complements (reverse) or both; a flat index built with --reverse-complement 1 finds both with a single backward search per read (fmindex) or part (pigeon)");
+    parser.add_option(options.threads, '\0', "threads", "number of threads the queries are split across");
+    parser.add_option(options.output_file, '\0', "output", "write every hit to this file");
+    parser.add_option(options.output_format, '\0', "output-format", "format of --output: tsv (read id, reference, position, strand, errors) or sam");
+    parser.add_option(options.dedup, '\0', "dedup", "search identical queries of a chunk once (1)");
+    parser.add_option(options.query_cache, '\0', "query-cache", "reuse the results of this many recent distinct queries across chunks, per thread");
+}
+
+bool parse_arguments(seqan3::argument_parser& parser) {
+    try {
+         parser.parse();
+    } catch (seqan3::argument_parser_error const& ext) {
+        seqan3::debug_stream << "Parsing error. " << ext.what() << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,240 @@
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <pthread.h>
+
+#include <seqan3/core/debug_stream.hpp>
+
+#include "bounded_queue.hpp"
+#include "search_engine.hpp"
+#include "search_protocol.hpp"
+
+namespace {
+
+// an index loaded once and served under a name
+struct served_index {
+    std::unique_ptr<search_engine> engine;
+    std::string sam_header;
+};
+
+using served_indexes = std::map<std::string, served_index>;
+
+// NAME=ENGINE:INDEX[:REFERENCE], e.g. hg38=fmindex:hg38.index or ref=naive::ref.fasta
+served_index load_index(std::string const& spec, search_options options, std::string& name) {
+    size_t equals = spec.find('=');
+    size_t colon = spec.find(':', equals);
+    if (equals == std::string::npos || equals == 0 || colon == std::string::npos) {
+        throw std::runtime_error("--serve expects NAME=ENGINE:INDEX[:REFERENCE], got " + spec);
+    }
+    name = spec.substr(0, equals);
+    std::string engine_name = spec.substr(equals + 1, colon - equals - 1);
+    std::string paths = spec.substr(colon + 1);
+    size_t split = paths.find(':');
+    options.index_path = paths.substr(0, split);
+    if (split != std::string::npos) options.reference_file = paths.substr(split + 1);
+
+    served_index index;
+    index.engine = make_search_engine(engine_name, options);
+    index.sam_header = sam_header(index.engine->sequence_lengths());
+    return index;
+}
+
+// every connection is served by one thread, which keeps a worker per index across its requests
+class connection_handler {
+    served_indexes const& indexes_;
+    search_options const& options_;
+    std::map<std::string, std::unique_ptr<search_worker>> workers_;
+
+    search_response answer(search_request const& request) {
+        auto index = indexes_.find(request.index);
+        if (index == indexes_.end()) {
+            throw std::runtime_error("unknown index " + request.index);
+        }
+        auto& worker = workers_[request.index];
+        if (!worker) worker = make_search_worker(*index->second.engine, options_);
+
+        bool const locate = request.format != "count";
+        std::optional<hit_formatter> formatter;
+        if (locate) formatter.emplace(parse_hit_format(request.format));
+
+        search_response response;
+        response.ok = true;
+        if (locate && request.format == "sam") response.body = index->second.sam_header;
+        for (auto const& chunk : parse_query_chunks(request.queries)) {
+            response.hits += worker->search(chunk, locate ? &*formatter : nullptr);
+            if (locate) response.body += formatter->take();
+        }
+        return response;
+    }
+
+public:
+    connection_handler(served_indexes const& indexes, search_options const& options)
+        : indexes_{indexes}, options_{options} {}
+
+    // answers requests until the client quits, a malformed or failed request is answered with an error; if the
+    // stream itself fails, the error is sent if possible and rethrown, ending the connection
+    void serve(int in, int out) {
+        fd_stream stream{in, out};
+        search_request request;
+        while (true) {
+            try {
+                if (!read_request(stream, request)) return;
+            } catch (protocol_error const& e) {
+                write_response(stream, search_response{false, 0, e.what()});
+                continue;
+            } catch (std::exception const& e) {
+                try {
+                    write_response(stream, search_response{false, 0, e.what()});
+                } catch (std::exception const&) {
+                }
+                throw;
+            }
+            search_response response;
+            try {
+                response = answer(request);
+            } catch (std::exception const& e) {
+                response = search_response{false, 0, e.what()};
+            }
+            write_response(stream, response);
+        }
+    }
+};
+
+} // namespace
+
+// keeps indexes resident and answers query batches, see search_protocol.hpp for the framing
+int main(int argc, char const* const* argv) {
+    seqan3::argument_parser parser{"search_server", argc, argv, seqan3::update_notifications::off};
+    init_parser(parser);
+
+    std::vector<std::string> serve;
+    std::filesystem::path socket_path;
+    search_options options;
+    parser.add_option(serve, '\0', "serve", "index to serve as NAME=ENGINE:INDEX[:REFERENCE], can be repeated");
+    parser.add_option(socket_path, '\0', "socket", "listen on this unix domain socket, requests are read from stdin if empty");
+    parser.add_option(options.threads, '\0', "threads", "number of connections served at the same time");
+    parser.add_option(options.errors, '\0', "error-total", "number of total errors (fmindex and pigeon)");
+    parser.add_option(options.bi_fm_index, '\0', "bi-fm-index", "load a fm-index (0); load a bi-fm-index (1) (fmindex)");
+    parser.add_option(options.search_scheme, '\0', "search-scheme", "search the bi-fm-index with a search scheme (fmindex)");
+    parser.add_option(options.indels, '\0', "indels", "verify candidates with hamming distance (0) or with edit distance (1); every candidate reports its best edit alignment, alignments beginning at the same position are reported once with their fewest errors (pigeon)");
+    parser.add_option(options.batched_seeding, '\0', "batched-seeding", "search the parts of all queries of a chunk together and verify their candidates in text order (1); parts sharing a suffix share backward search steps only on a flat (mmap) index (pigeon)");
+    parser.add_option(options.multi_pattern, '\0', "multi-pattern", "match all queries of a chunk in one pass over the reference (1) (naive)");
+    parser.add_option(options.scan_threads, '\0', "scan-threads", "number of threads the reference is split across for every chunk of queries (naive)");
+    parser.add_option(options.strand, '\0', "strand", "search the queries (forward), their reverse complements (reverse) or both; a flat index built with --reverse-complement 1 finds both with a single backward search per read (fmindex) or part (pigeon)");
+    parser.add_option(options.dedup, '\0', "dedup", "search identical queries of a request once (1)");
+    parser.add_option(options.query_cache, '\0', "query-cache", "reuse the results of this many recent distinct queries across requests, per thread");
+    if (!parse_arguments(parser)) return EXIT_FAILURE;
+
+    if (serve.empty()) {
+        seqan3::debug_stream << "nothing to serve, pass at least one --serve\n";
+        return EXIT_FAILURE;
+    }
+    if (options.threads == 0) {
+        throw std::runtime_error("threads must be at least 1");
+    }
+
+    served_indexes indexes;
+    for (auto const& spec : serve) {
+        std::string name;
+        auto index = load_index(spec, options, name);
+        if (!indexes.emplace(name, std::move(index)).second) {
+            throw std::runtime_error("index " + name + " is served twice");
+        }
+    }
+
+    // a client that disconnects early must not take the server down with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (socket_path.empty()) {
+        try {
+            connection_handler{indexes, options}.serve(STDIN_FILENO, STDOUT_FILENO);
+        } catch (std::exception const& e) {
+            seqan3::debug_stream << "connection dropped: " << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
+
+    // SIGINT and SIGTERM are blocked in every thread and taken by a watcher, which stops the server: the listener
+    // stops accepting, queued connections are closed unanswered and open connections are shut down for reading, so
+    // every handler answers the requests it has received and returns
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+    int listener = listen_unix_socket(socket_path);
+    seqan3::debug_stream << "Listening on " << socket_path.string() << '\n';
+    bounded_queue<int> connections{options.threads};
+    std::mutex open_mutex;
+    std::set<int> open_connections;
+    std::atomic<bool> stopping = false;
+    std::vector<std::thread> handlers;
+    for (size_t t = 0; t < options.threads; ++t) {
+        handlers.emplace_back([&] {
+            connection_handler handler{indexes, options};
+            while (auto fd = connections.pop()) {
+                {
+                    std::lock_guard lock{open_mutex};
+                    if (stopping) {
+                        ::close(*fd);
+                        continue;
+                    }
+                    open_connections.insert(*fd);
+                }
+                try {
+                    handler.serve(*fd, *fd);
+                } catch (std::exception const& e) {
+                    seqan3::debug_stream << "connection dropped: " << e.what() << '\n';
+                }
+                {
+                    std::lock_guard lock{open_mutex};
+                    open_connections.erase(*fd);
+                }
+                ::close(*fd);
+            }
+        });
+    }
+    int stop_signal = 0;
+    std::thread watcher{[&] {
+        sigwait(&stop_signals, &stop_signal);
+        {
+            std::lock_guard lock{open_mutex};
+            stopping = true;
+            for (int fd : open_connections) ::shutdown(fd, SHUT_RD);
+        }
+        ::shutdown(listener, SHUT_RDWR);
+        connections.close();
+    }};
+
+    bool failed = false;
+    while (true) {
+        int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0 && errno == EINTR) continue;
+        if (fd < 0) {
+            if (!stopping) {
+                seqan3::debug_stream << "accept failed: " << std::strerror(errno) << '\n';
+                failed = true;
+            }
+            break;
+        }
+        if (!connections.push(fd)) {
+            ::close(fd);
+            break;
+        }
+    }
+    // the watcher stops the handlers as well if accepting failed
+    if (!stopping) pthread_kill(watcher.native_handle(), SIGTERM);
+    watcher.join();
+    for (auto& handler : handlers) handler.join();
+    ::close(listener);
+    std::filesystem::remove(socket_path);
+    if (!failed) seqan3::debug_stream << "stopped by signal " << stop_signal << '\n';
+    return failed ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,120 @@
+#include <divsufsort.h>
+#include <optional>
+#include <stdexcept>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+#include <seqan3/core/debug_stream.hpp>
+
+#include "packed_reference_file.hpp"
+#include "search_engine.hpp"
+#include "strand.hpp"
+#include "suffix_array_index.hpp"
+#include "suffix_array_search.hpp"
+
+namespace {
+
+class suffix_array_engine : public search_engine {
+    // the reference is held 2-bit packed, either mmap'ed from a prebuilt index or built right here
+    // the suffix array has 32-bit entries, unless the reference has 2^31 characters or more
+    std::optional<suffix_array_index> index_;
+    std::optional<reference_text> built_reference_;
+    std::vector<saidx_t> built_suffixarray_;
+    std::vector<saidx64_t> built_suffixarray64_;
+    packed_reference_view reference_;
+    sequence_boundaries boundaries_;
+    saidx_t const* suffixarray_ = nullptr;
+    saidx64_t const* suffixarray64_ = nullptr;
+    strand_mode mode_;
+
+    class worker : public search_worker {
+        suffix_array_engine const& engine_;
+        std::vector<seqan3::dna5> reverse_query_;
+
+        template <typename sa_value_t>
+        uint64_t search_all(sa_value_t const* suffixarray, query_chunk const& chunk, hit_sink* hits,
+                            std::span<uint64_t> query_counts) {
+            auto const& boundaries = engine_.boundaries_;
+            uint64_t count = 0;
+            for (size_t q = 0; q < chunk.queries.size(); ++q) {
+                auto const& read = chunk.queries[q];
+                for (char strand : strands(engine_.mode_)) {
+                    if (strand == '-') reverse_complement(read, reverse_query_);
+                    auto const& query = strand == '+' ? read : reverse_query_;
+                    // two independent binary searches for the first and one past the last matching suffix,
+                    // suffixes end at their sequence end, so every suffix in between is an occurrence
+                    auto [lower, upper] = sa_equal_range(engine_.reference_, boundaries, suffixarray, query);
+                    count += upper - lower;
+                    if (!query_counts.empty()) query_counts[q] += upper - lower;
+                    if (!hits) continue;
+                    for (uint64_t i = lower; i < upper; ++i) {
+                        auto [sequence_id, offset] = boundaries.to_sequence_position(static_cast<uint64_t>(suffixarray[i]));
+                        hits->add(chunk.ids[q], read, hit{sequence_id, offset, strand, 0, false});
+                    }
+                }
+            }
+            return count;
+        }
+
+    public:
+        explicit worker(suffix_array_engine const& engine) : engine_{engine} {}
+
+        uint64_t search(query_chunk const& chunk, hit_sink* hits, std::span<uint64_t> query_counts) override {
+            if (engine_.suffixarray64_ != nullptr) {
+                return search_all(engine_.suffixarray64_, chunk, hits, query_counts);
+            }
+            return search_all(engine_.suffixarray_, chunk, hits, query_counts);
+        }
+    };
+
+public:
+    explicit suffix_array_engine(search_options const& options) : mode_{parse_strand_mode(options.strand)} {
+        if (!options.index_path.empty()) {
+            seqan3::debug_stream << "Mapping Suffix-Array Index ... " << std::flush;
+            index_.emplace(options.index_path);
+            reference_ = index_->text();
+            boundaries_ = index_->boundaries();
+            if (index_->sa_width() == sizeof(saidx64_t)) {
+                suffixarray64_ = index_->suffix_array<saidx64_t>();
+            } else {
+                suffixarray_ = index_->suffix_array<saidx_t>();
+            }
+            seqan3::debug_stream << "done\n";
+            return;
+        }
+        // read reference into memory
+        // all sequences are concatenated into one text, the boundary table keeps their borders
+        built_reference_.emplace(options.reference_file);
+        reference_ = built_reference_->view();
+        boundaries_ = built_reference_->boundaries();
+        if (needs_64bit_suffix_array(reference_, boundaries_)) {
+            built_suffixarray64_ = build_suffix_array<saidx64_t>(reference_, boundaries_);
+            suffixarray64_ = built_suffixarray64_.data();
+        } else {
+            built_suffixarray_ = build_suffix_array<saidx_t>(reference_, boundaries_);
+            suffixarray_ = built_suffixarray_.data();
+        }
+    }
+
+    std::string method() const override { return "Suffix-Array"; }
+
+    std::vector<uint64_t> sequence_lengths() const override {
+        std::vector<uint64_t> lengths;
+        for (uint64_t id = 0; id < boundaries_.count; ++id) {
+            lengths.push_back(boundaries_.end(id) - boundaries_.start(id));
+        }
+        return lengths;
+    }
+
+    std::unique_ptr<search_worker> make_worker() const override {
+        return std::make_unique<worker>(*this);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<search_engine> make_suffix_array_engine(search_options const& options) {
+    if (options.errors != 0) {
+        throw std::runtime_error("the suffix array search only finds exact matches");
+    }
+    return std::make_unique<suffix_array_engine>(options);
+}
@@ -0,0 +1,54 @@
+#include <sstream>
+#include <filesystem>
+
+#include <seqan3/alphabet/nucleotide/dna5.hpp>
+#include <seqan3/argument_parser/all.hpp>
+#include <seqan3/core/debug_stream.hpp>
+#include <seqan3/io/sequence_file/all.hpp>
+
+#include "packed_reference_file.hpp"
+#include "suffix_array_index.hpp"
+
+int main(int argc, char const* const* argv) {
+    seqan3::argument_parser parser{"suffixarray_construct", argc, argv, seqan3::update_notifications::off};
+
+    parser.info.author = "SeqAn-Team";
+    parser.info.version = "1.0.0";
+
+    auto reference_file = std::filesystem::path{};
+    parser.add_option(reference_file, '\0', "reference", "path to the reference file (sequence file or packed reference)");
+
+    auto index_path = std::filesystem::path{};
+    parser.add_option(index_path, '\0', "index", "path to the index file that is written");
+
+    try {
+         parser.parse();
+    } catch (seqan3::argument_parser_error const& ext) {
+        seqan3::debug_stream << "Parsing error. " << ext.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // the reference is packed while it is read, or mmap'ed if it already is a packed reference
+    reference_text reference{reference_file};
+    std::vector<uint64_t> sequence_starts;
+    for (uint64_t id = 0; id <= reference.sequence_count(); ++id) {
+        sequence_starts.push_back(reference.sequence_start(id));
+    }
+
+    // 32-bit entries halve the memory footprint, full genomes need 64-bit ones
+    auto build_and_save = [&](auto const& suffixarray) {
+        seqan3::debug_stream << "done\n";
+        seqan3::debug_stream << "Saving Suffix-Array Index ... " << std::flush;
+        save_suffix_array_index(index_path, reference.view(), sequence_starts, suffixarray);
+        seqan3::debug_stream << "done\n";
+    };
+    if (needs_64bit_suffix_array(reference.view(), reference.boundaries())) {
+        seqan3::debug_stream << "Building 64-bit Suffix-Array ... " << std::flush;
+        build_and_save(build_suffix_array<saidx64_t>(reference.view(), reference.boundaries()));
+    } else {
+        seqan3::debug_stream << "Building Suffix-Array ... " << std::flush;
+        build_and_save(build_suffix_array<saidx_t>(reference.view(), reference.boundaries()));
+    }
+
+    return 0;
+}